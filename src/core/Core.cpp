@@ -1,8 +1,10 @@
 #include "Core.h"
 
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 
 #include <glad/gl.h>
 #include <imgui.h>
@@ -14,7 +16,9 @@
 #include "RenderPlugin.h"
 #include "util/FileUtil.h"
 #include "util/GLFWUtil.h"
+#include "util/GLStateCache.h"
 #include "util/GLUtil.h"
+#include "util/GpuMemoryLedger.h"
 
 using namespace OGL4Core2::Core;
 
@@ -30,9 +34,20 @@ static constexpr char imguiGlslVersion[] = "#version 450";
 #endif
 static constexpr char title[] = "OGL4Core2";
 
+static std::filesystem::path cachePath(const std::string& name) {
+    std::error_code ec;
+    std::filesystem::path tmp = std::filesystem::temp_directory_path(ec);
+    if (ec) {
+        tmp = std::filesystem::current_path();
+    }
+    return tmp / "OGL4Core2" / name;
+}
+
 Core::Core()
     : window_(nullptr),
       running_(false),
+      threadPool_(std::make_unique<ThreadPool>(std::max(std::thread::hardware_concurrency(), 2u) - 1)),
+      shaderCache_(std::make_unique<ShaderCache>(cachePath("shadercache"))),
       currentPlugin_(nullptr),
       currentPluginIdx_(-1),
       pluginSelectionIdx_(0),
@@ -151,6 +166,9 @@ Core::~Core() {
     // Delete active plugin here, before destroying the OpenGL context.
     camera_.reset();
     currentPlugin_ = nullptr;
+    if (GpuMemoryLedger::owner() != "Core") {
+        GpuMemoryLedger::checkReleased(GpuMemoryLedger::owner());
+    }
 
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
@@ -211,6 +229,18 @@ void Core::removeCamera() const {
     camera_.reset();
 }
 
+ThreadPool& Core::getThreadPool() const {
+    return *threadPool_;
+}
+
+ShaderCache& Core::getShaderCache() const {
+    return *shaderCache_;
+}
+
+std::filesystem::path Core::getProfilesPath() const {
+    return cachePath("profiles");
+}
+
 void Core::validateImGuiScale() {
     float xscale, yscale;
     glfwGetWindowContentScale(window_, &xscale, &yscale);
@@ -258,14 +288,28 @@ void Core::draw() {
     if (ImGui::CollapsingHeader("Plugins", ImGuiTreeNodeFlags_DefaultOpen)) {
         ImGui::Combo("Plugin", &pluginSelectionIdx_, pluginNamesImGui_.data());
     }
+    if (ImGui::CollapsingHeader("GPU Memory")) {
+        GpuMemoryLedger::drawGUI();
+    }
+    if (ImGui::CollapsingHeader("GL State")) {
+        GLStateCache::drawGUI();
+    }
     if (currentPluginIdx_ != pluginSelectionIdx_) {
         currentPluginIdx_ = pluginSelectionIdx_;
         // Need to delete plugin first, so destructor of old plugin runs before constructor of new plugin.
         // Otherwise, this could mess up OpenGL states.
         currentPlugin_ = nullptr;
+        // Every texture, buffer and program of the old plugin must be gone with it.
+        if (GpuMemoryLedger::owner() != "Core") {
+            GpuMemoryLedger::checkReleased(GpuMemoryLedger::owner());
+        }
+
+        // The new plugin starts with unknown state, whatever the old one left bound.
+        GLStateCache::invalidate();
 
         // Init new plugin
         const auto& plugin = PluginRegister::get(currentPluginIdx_);
+        GpuMemoryLedger::setOwner(plugin->name());
 
         // Get plugin resource dir. This is done here, that we can keep access to path const as plugins should only
         // get a const reference to core. But as having a resource dir is optional for plugins, we want to show an
@@ -287,6 +331,7 @@ void Core::draw() {
     if (currentPlugin_ != nullptr) {
         currentPlugin_->render();
     }
+    GLStateCache::endFrame();
 
     ImGui::End();
     ImGui::Render();
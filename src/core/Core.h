@@ -12,7 +12,9 @@
 
 #include "camera/AbstractCamera.h"
 #include "Input.h"
+#include "shader/ShaderCache.h"
 #include "util/FpsCounter.h"
+#include "util/ThreadPool.h"
 
 namespace OGL4Core2::Core {
     class RenderPlugin;
@@ -35,6 +37,11 @@ namespace OGL4Core2::Core {
         void registerCamera(const std::shared_ptr<AbstractCamera>& camera) const;
         void removeCamera() const;
 
+        [[nodiscard]] ThreadPool& getThreadPool() const;
+        [[nodiscard]] ShaderCache& getShaderCache() const;
+        // Directory for per-GPU tuning results of the plugins, may not exist yet.
+        [[nodiscard]] std::filesystem::path getProfilesPath() const;
+
     private:
         void validateImGuiScale();
         void draw();
@@ -54,6 +61,9 @@ namespace OGL4Core2::Core {
 
         FpsCounter fps_;
 
+        std::unique_ptr<ThreadPool> threadPool_;
+        std::unique_ptr<ShaderCache> shaderCache_;
+
         std::shared_ptr<RenderPlugin> currentPlugin_;
         std::filesystem::path currentPluginResourcesPath_;
         std::exception currentPluginResourcesPathException_;
@@ -10,6 +10,18 @@
 #include <lodepng.h>
 
 #include "Core.h"
+#include "util/Ktx2File.h"
+
+// EXT_texture_compression_s3tc and EXT_texture_sRGB, not part of the core profile loaded by glad.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
 
 using namespace OGL4Core2::Core;
 
@@ -56,8 +68,7 @@ std::filesystem::path RenderPlugin::getResourceDirPath(const std::string& name)
     return path;
 }
 
-std::string RenderPlugin::getStringResource(const std::string& name) const {
-    std::filesystem::path path = getResourceFilePath(name);
+static std::string readStringFile(const std::filesystem::path& path) {
     std::ifstream file(path);
     if (!file.is_open()) {
         throw std::runtime_error("Cannot read resource file \"" + path.string() + "\"!");
@@ -67,17 +78,36 @@ std::string RenderPlugin::getStringResource(const std::string& name) const {
     return buffer.str();
 }
 
-std::vector<unsigned char> RenderPlugin::getPngResource(const std::string& name, int& width, int& height) const {
-    std::vector<unsigned char> image;
+static PngImage decodePngFile(const std::filesystem::path& path) {
+    PngImage png;
     unsigned int w, h;
-    unsigned int error = lodepng::decode(image, w, h, getResourceFilePath(name).string());
+    unsigned int error = lodepng::decode(png.data, w, h, path.string());
     if (error != 0) {
         std::string errorText = lodepng_error_text(error);
         throw std::runtime_error("Cannot load PNG resource: " + errorText);
     }
-    width = static_cast<int>(w);
-    height = static_cast<int>(h);
-    return image;
+    png.width = static_cast<int>(w);
+    png.height = static_cast<int>(h);
+    return png;
+}
+
+std::string RenderPlugin::getStringResource(const std::string& name) const {
+    return readStringFile(getResourceFilePath(name));
+}
+
+std::vector<unsigned char> RenderPlugin::getPngResource(const std::string& name, int& width, int& height) const {
+    PngImage png = decodePngFile(getResourceFilePath(name));
+    width = png.width;
+    height = png.height;
+    return std::move(png.data);
+}
+
+std::future<std::string> RenderPlugin::loadStringAsync(const std::string& name) const {
+    return core_.getThreadPool().submit([path = getResourceFilePath(name)]() { return readStringFile(path); });
+}
+
+std::future<PngImage> RenderPlugin::loadPngAsync(const std::string& name) const {
+    return core_.getThreadPool().submit([path = getResourceFilePath(name)]() { return decodePngFile(path); });
 }
 
 std::shared_ptr<glowl::Texture2D> RenderPlugin::getTextureResource(const std::string& name) const {
@@ -94,6 +124,72 @@ std::shared_ptr<glowl::Texture2D> RenderPlugin::getTextureResource(const std::st
     return std::make_shared<glowl::Texture2D>(name, layout, image.data());
 }
 
+/**
+ * Load a block compressed KTX2 cubemap with all mip levels. The returned texture is owned by the caller. Throws if
+ * the file cannot be read or the driver does not support S3TC, so callers can fall back to uncompressed images.
+ */
+TextureHandle RenderPlugin::getKtx2CubemapResource(const std::string& name) const {
+    bool s3tcSupported = false;
+    GLint numExtensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+    for (GLint i = 0; i < numExtensions; i++) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension != nullptr && std::string(extension) == "GL_EXT_texture_compression_s3tc") {
+            s3tcSupported = true;
+            break;
+        }
+    }
+    if (!s3tcSupported) {
+        throw std::runtime_error("Cannot load KTX2 resource \"" + name + "\": S3TC is not supported!");
+    }
+
+    Ktx2File ktx(getResourceFilePath(name));
+    if (ktx.faceCount() != 6) {
+        throw std::runtime_error("KTX2 resource \"" + name + "\" is not a cubemap!");
+    }
+    GLenum internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    if (ktx.vkFormat() == Ktx2File::VK_FORMAT_BC1_RGB_SRGB_BLOCK) {
+        internalFormat = GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+    } else if (ktx.vkFormat() == Ktx2File::VK_FORMAT_BC1_RGBA_UNORM_BLOCK) {
+        internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    }
+
+    TextureHandle texture(GL_TEXTURE_CUBE_MAP, "Resources");
+    glTextureStorage2D(texture, ktx.levelCount(), internalFormat, ktx.width(), ktx.height());
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, ktx.levelCount() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    std::size_t bytes = 0;
+    for (int level = 0; level < ktx.levelCount(); level++) {
+        const GLsizei w = std::max(ktx.width() >> level, 1);
+        const GLsizei h = std::max(ktx.height() >> level, 1);
+        for (int face = 0; face < 6; face++) {
+            // faces of a cubemap with immutable storage are layers of a 3D image
+            glCompressedTextureSubImage3D(texture, level, 0, 0, face, w, h, 1, internalFormat,
+                static_cast<GLsizei>(ktx.imageSize(level)), ktx.image(level, face));
+            bytes += ktx.imageSize(level);
+        }
+    }
+    texture.setBytes(bytes);
+    return texture;
+}
+
+std::string RenderPlugin::getShaderResource(const std::string& name,
+    const ShaderPreprocessor::Defines& defines) const {
+    std::string nameClean = name;
+    std::replace(nameClean.begin(), nameClean.end(), '\\', '/');
+    const std::size_t slash = nameClean.find_last_of('/');
+    const std::string dir = slash == std::string::npos ? std::string() : nameClean.substr(0, slash + 1);
+    return ShaderPreprocessor::process(getStringResource(nameClean), defines,
+        [this, &dir](const std::string& include) { return getStringResource(dir + include); });
+}
+
+std::unique_ptr<ShaderProgram> RenderPlugin::getShaderProgram(const ShaderProgram::ShaderSourceList& sources) const {
+    return core_.getShaderCache().getProgram(sources);
+}
+
 std::vector<std::filesystem::path> RenderPlugin::getResourceDirFilePaths(const std::string& name,
     const std::string& filter) const {
     std::filesystem::path dir = getResourceDirPath(name);
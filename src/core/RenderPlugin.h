@@ -1,6 +1,7 @@
 #pragma once
 
 #include <filesystem>
+#include <future>
 #include <memory>
 #include <string>
 #include <vector>
@@ -9,10 +10,19 @@
 #include <glowl/glowl.h>
 
 #include "Input.h"
+#include "shader/ShaderPreprocessor.h"
+#include "shader/ShaderProgram.h"
+#include "util/GLHandle.h"
 
 namespace OGL4Core2::Core {
     class Core;
 
+    struct PngImage {
+        std::vector<unsigned char> data; // RGBA8
+        int width;
+        int height;
+    };
+
     class RenderPlugin {
     public:
         explicit RenderPlugin(const Core& c);
@@ -32,7 +42,17 @@ namespace OGL4Core2::Core {
         [[nodiscard]] std::filesystem::path getResourceDirPath(const std::string& name) const;
         [[nodiscard]] std::string getStringResource(const std::string& name) const;
         [[nodiscard]] std::vector<unsigned char> getPngResource(const std::string& name, int& width, int& height) const;
+        // Shader source with #include directives resolved relative to its directory and the defines injected.
+        [[nodiscard]] std::string getShaderResource(const std::string& name,
+            const ShaderPreprocessor::Defines& defines = {}) const;
         [[nodiscard]] std::shared_ptr<glowl::Texture2D> getTextureResource(const std::string& name) const;
+        // Decode on the worker threads of the core, the path is resolved immediately so a missing file throws here.
+        [[nodiscard]] std::future<std::string> loadStringAsync(const std::string& name) const;
+        [[nodiscard]] std::future<PngImage> loadPngAsync(const std::string& name) const;
+        // Linked program from the shared program binary cache, compiled from source on a cache miss.
+        [[nodiscard]] std::unique_ptr<ShaderProgram> getShaderProgram(
+            const ShaderProgram::ShaderSourceList& sources) const;
+        [[nodiscard]] TextureHandle getKtx2CubemapResource(const std::string& name) const;
         [[nodiscard]] std::vector<std::filesystem::path> getResourceDirFilePaths(const std::string& name,
             const std::string& filter = std::string()) const;
 
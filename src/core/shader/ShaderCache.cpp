@@ -0,0 +1,170 @@
+#include "ShaderCache.h"
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+using namespace OGL4Core2::Core;
+
+static constexpr char binaryMagic[8] = {'O', 'G', 'L', 'P', 'B', 'I', 'N', '1'};
+
+// FNV-1a, only used to name cache files
+static uint64_t fnv1a(const void* data, std::size_t size, uint64_t hash) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+ShaderCache::ShaderCache(std::filesystem::path directory)
+    : directory_(std::move(directory)),
+      supported_(true),
+      hits_(0),
+      misses_(0) {}
+
+std::unique_ptr<ShaderProgram> ShaderCache::getProgram(const ShaderProgram::ShaderSourceList& sources) {
+    GLuint program = load(sources);
+    if (program == 0) {
+        program = ShaderProgram::compile(sources, retrievable());
+        store(sources, program);
+    }
+    return std::make_unique<ShaderProgram>(program);
+}
+
+GLuint ShaderCache::load(const ShaderProgram::ShaderSourceList& sources) {
+    queryDriver();
+    GLuint program = supported_ ? loadBinary(binaryPath(sources)) : 0;
+    if (program != 0) {
+        hits_++;
+    } else {
+        misses_++;
+    }
+    return program;
+}
+
+void ShaderCache::store(const ShaderProgram::ShaderSourceList& sources, GLuint program) {
+    queryDriver();
+    if (supported_) {
+        storeBinary(binaryPath(sources), program);
+    }
+}
+
+bool ShaderCache::retrievable() {
+    queryDriver();
+    return supported_;
+}
+
+void ShaderCache::queryDriver() {
+    if (!driver_.empty()) {
+        return;
+    }
+    const auto* vendor = reinterpret_cast<const char*>(glGetString(GL_VENDOR));
+    const auto* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    const auto* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    driver_ = std::string(vendor ? vendor : "") + "\n" + (renderer ? renderer : "") + "\n" + (version ? version : "");
+
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    supported_ = formats > 0;
+    if (supported_) {
+        std::error_code ec;
+        std::filesystem::create_directories(directory_, ec);
+        supported_ = !ec;
+    }
+}
+
+std::filesystem::path ShaderCache::binaryPath(const ShaderProgram::ShaderSourceList& sources) const {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    hash = fnv1a(driver_.data(), driver_.size(), hash);
+    for (const auto& [type, source] : sources) {
+        const auto glType = static_cast<GLenum>(type);
+        hash = fnv1a(&glType, sizeof(glType), hash);
+        hash = fnv1a(source.data(), source.size(), hash);
+    }
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << hash << ".bin";
+    return directory_ / name.str();
+}
+
+/**
+ * Returns 0 if there is no cached binary, the file does not match its header or the driver rejects it.
+ */
+GLuint ShaderCache::loadBinary(const std::filesystem::path& path) const {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return 0;
+    }
+    char magic[sizeof(binaryMagic)];
+    uint32_t format = 0;
+    uint32_t length = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&format), sizeof(format));
+    file.read(reinterpret_cast<char*>(&length), sizeof(length));
+    if (!file.good() || std::memcmp(magic, binaryMagic, sizeof(magic)) != 0) {
+        return 0;
+    }
+    // the binary is the rest of the file, a truncated or corrupt length must not size the allocation
+    constexpr std::uintmax_t headerSize = sizeof(binaryMagic) + 2 * sizeof(uint32_t);
+    std::error_code ec;
+    const std::uintmax_t fileSize = std::filesystem::file_size(path, ec);
+    if (ec || length == 0 || fileSize != headerSize + length) {
+        return 0;
+    }
+    std::vector<char> binary(length);
+    file.read(binary.data(), length);
+    if (!file.good()) {
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, format, binary.data(), static_cast<GLsizei>(length));
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+void ShaderCache::storeBinary(const std::filesystem::path& path, GLuint program) const {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    // write to a temporary file first, so a concurrent reader never sees a partial binary
+    std::filesystem::path tmpPath = path;
+    tmpPath += ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary);
+        if (!file.is_open()) {
+            return;
+        }
+        const auto format32 = static_cast<uint32_t>(format);
+        const auto length32 = static_cast<uint32_t>(length);
+        file.write(binaryMagic, sizeof(binaryMagic));
+        file.write(reinterpret_cast<const char*>(&format32), sizeof(format32));
+        file.write(reinterpret_cast<const char*>(&length32), sizeof(length32));
+        file.write(binary.data(), length);
+        if (!file.good()) {
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::cerr << "Cannot store program binary \"" << path.string() << "\": " << ec.message() << std::endl;
+        std::filesystem::remove(tmpPath, ec);
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include "ShaderProgram.h"
+
+namespace OGL4Core2::Core {
+    /**
+     * On-disk cache of linked program binaries. The key is a hash of all shader sources (defines are part of the
+     * source) and the GL vendor, renderer and version strings, so a driver update invalidates the cache. Binaries the
+     * driver rejects are recompiled from source and replaced.
+     */
+    class ShaderCache {
+    public:
+        explicit ShaderCache(std::filesystem::path directory);
+
+        /** Load the program from the cache or compile it. Throws ShaderProgramException on compile errors. */
+        [[nodiscard]] std::unique_ptr<ShaderProgram> getProgram(const ShaderProgram::ShaderSourceList& sources);
+
+        /** Cached program or 0 on a miss, for callers that compile on their own. */
+        [[nodiscard]] GLuint load(const ShaderProgram::ShaderSourceList& sources);
+        /** Store the binary of a program that was linked with the retrievable hint. */
+        void store(const ShaderProgram::ShaderSourceList& sources, GLuint program);
+        /** Whether programs should be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT. */
+        [[nodiscard]] bool retrievable();
+
+        [[nodiscard]] inline std::size_t hits() const {
+            return hits_;
+        }
+        [[nodiscard]] inline std::size_t misses() const {
+            return misses_;
+        }
+
+    private:
+        void queryDriver();
+        [[nodiscard]] std::filesystem::path binaryPath(const ShaderProgram::ShaderSourceList& sources) const;
+        GLuint loadBinary(const std::filesystem::path& path) const;
+        void storeBinary(const std::filesystem::path& path, GLuint program) const;
+
+        std::filesystem::path directory_;
+        std::string driver_; // vendor, renderer and version, queried on first use when a context exists
+        bool supported_;
+        std::size_t hits_;
+        std::size_t misses_;
+    };
+} // namespace OGL4Core2::Core
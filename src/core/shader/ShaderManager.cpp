@@ -0,0 +1,118 @@
+#include "ShaderManager.h"
+
+#include <iostream>
+#include <utility>
+
+// clang-format off
+#include <glad/gl.h>
+#include <GLFW/glfw3.h>
+// clang-format on
+
+// KHR_parallel_shader_compile and ARB_parallel_shader_compile, not loaded by glad.
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+using namespace OGL4Core2::Core;
+
+typedef void(GLAD_API_PTR* PFNMAXSHADERCOMPILERTHREADSPROC)(GLuint count);
+
+ShaderManager::ShaderManager(ShaderCache& cache) : cache_(cache), parallel_(false) {
+    const char* names[2][2] = {
+        {"GL_KHR_parallel_shader_compile", "glMaxShaderCompilerThreadsKHR"},
+        {"GL_ARB_parallel_shader_compile", "glMaxShaderCompilerThreadsARB"},
+    };
+    for (const auto& [extension, function] : names) {
+        if (glfwExtensionSupported(extension) == GLFW_TRUE) {
+            auto maxThreads = reinterpret_cast<PFNMAXSHADERCOMPILERTHREADSPROC>(glfwGetProcAddress(function));
+            if (maxThreads != nullptr) {
+                maxThreads(0xFFFFFFFFu); // let the driver choose
+            }
+            parallel_ = true;
+            break;
+        }
+    }
+}
+
+ShaderManager::~ShaderManager() {
+    for (auto& request : pending_) {
+        if (request.started) {
+            ShaderProgram::discardCompile(request.compile);
+        }
+    }
+}
+
+void ShaderManager::submit(std::unique_ptr<ShaderProgram>& target, const std::string& name,
+    ShaderProgram::ShaderSourceList sources) {
+    cancel(target);
+
+    GLuint program = cache_.load(sources);
+    if (program != 0) {
+        target = std::make_unique<ShaderProgram>(program);
+        return;
+    }
+
+    pending_.push_back({&target, name, std::move(sources), {0, {}}, false});
+    if (parallel_) {
+        start(pending_.back());
+    }
+}
+
+void ShaderManager::cancel(std::unique_ptr<ShaderProgram>& target) {
+    for (auto it = pending_.begin(); it != pending_.end(); ++it) {
+        if (it->target == &target) {
+            if (it->started) {
+                ShaderProgram::discardCompile(it->compile);
+            }
+            pending_.erase(it);
+            return;
+        }
+    }
+}
+
+bool ShaderManager::pending(const std::unique_ptr<ShaderProgram>& target) const {
+    for (const auto& request : pending_) {
+        if (request.target == &target) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ShaderManager::poll() {
+    if (!parallel_) {
+        if (!pending_.empty()) {
+            start(pending_.front());
+            finish(pending_.front());
+            pending_.pop_front();
+        }
+        return;
+    }
+
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        GLint done = GL_FALSE;
+        glGetProgramiv(it->compile.program, GL_COMPLETION_STATUS_KHR, &done);
+        if (done == GL_TRUE) {
+            finish(*it);
+            it = pending_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ShaderManager::start(Request& request) {
+    request.compile = ShaderProgram::beginCompile(request.sources, cache_.retrievable());
+    request.started = true;
+}
+
+void ShaderManager::finish(Request& request) {
+    try {
+        GLuint program = ShaderProgram::finishCompile(request.compile);
+        cache_.store(request.sources, program);
+        *request.target = std::make_unique<ShaderProgram>(program);
+    } catch (const ShaderProgramException& e) {
+        std::cerr << request.name << ": " << e.what() << std::endl;
+    }
+    request.started = false;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "ShaderCache.h"
+#include "ShaderProgram.h"
+
+namespace OGL4Core2::Core {
+    /**
+     * Compiles programs in the background while the plugin keeps rendering. Programs are handed to their target
+     * pointer once linked, so a render pass can simply be skipped while its pointer is still empty.
+     *
+     * With KHR_parallel_shader_compile (or the ARB variant) all programs are submitted at once and the driver
+     * compiles them on its own threads, poll() only checks GL_COMPLETION_STATUS_KHR. Without the extension one
+     * program is compiled per poll(), in submission order, so the first passes become available early.
+     */
+    class ShaderManager {
+    public:
+        explicit ShaderManager(ShaderCache& cache);
+        ~ShaderManager();
+
+        ShaderManager(const ShaderManager&) = delete;
+        ShaderManager(ShaderManager&&) = delete;
+        ShaderManager& operator=(const ShaderManager&) = delete;
+        ShaderManager& operator=(ShaderManager&&) = delete;
+
+        /**
+         * Request a program for target. Cached binaries are assigned immediately, otherwise target keeps its current
+         * value until the compile finished. A newer request for the same target replaces a pending one. Compile
+         * errors are printed and leave target unchanged.
+         */
+        void submit(std::unique_ptr<ShaderProgram>& target, const std::string& name,
+            ShaderProgram::ShaderSourceList sources);
+
+        /** Drop a pending request for target, target keeps its current value. */
+        void cancel(std::unique_ptr<ShaderProgram>& target);
+
+        /** Finish ready programs, call once per frame. */
+        void poll();
+
+        [[nodiscard]] inline std::size_t pending() const {
+            return pending_.size();
+        }
+        /** True while a request for target is not finished, afterwards an empty target failed to compile. */
+        [[nodiscard]] bool pending(const std::unique_ptr<ShaderProgram>& target) const;
+        [[nodiscard]] inline bool parallel() const {
+            return parallel_;
+        }
+
+    private:
+        struct Request {
+            std::unique_ptr<ShaderProgram>* target;
+            std::string name;
+            ShaderProgram::ShaderSourceList sources;
+            ShaderProgram::PendingCompile compile;
+            bool started;
+        };
+
+        void start(Request& request);
+        void finish(Request& request);
+
+        ShaderCache& cache_;
+        std::list<Request> pending_;
+        bool parallel_;
+    };
+} // namespace OGL4Core2::Core
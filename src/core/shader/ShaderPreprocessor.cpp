@@ -0,0 +1,79 @@
+#include "ShaderPreprocessor.h"
+
+#include <algorithm>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+
+using namespace OGL4Core2::Core;
+
+std::string ShaderPreprocessor::process(const std::string& source, const Defines& defines,
+    const IncludeLoader& loader) {
+    std::set<std::string> active;
+    std::set<std::string> included;
+    std::string result = resolveIncludes(source, std::string(), loader, active, included);
+
+    const std::string defineBlock = defineString(defines);
+    if (defineBlock.empty()) {
+        return result;
+    }
+    // #version must stay the first statement, the defines follow it and #line restores the numbering.
+    std::size_t versionPos = result.find("#version");
+    if (versionPos == std::string::npos) {
+        return defineBlock + "#line 1\n" + result;
+    }
+    std::size_t lineEnd = result.find('\n', versionPos);
+    if (lineEnd == std::string::npos) {
+        return result + "\n" + defineBlock;
+    }
+    const auto versionLine = std::count(result.begin(), result.begin() + static_cast<std::ptrdiff_t>(lineEnd), '\n');
+    return result.substr(0, lineEnd + 1) + defineBlock + "#line " + std::to_string(versionLine + 2) + "\n" +
+           result.substr(lineEnd + 1);
+}
+
+std::string ShaderPreprocessor::defineString(const Defines& defines) {
+    std::string result;
+    for (const auto& [name, value] : defines) {
+        result += "#define " + name;
+        if (!value.empty()) {
+            result += " " + value;
+        }
+        result += "\n";
+    }
+    return result;
+}
+
+std::string ShaderPreprocessor::resolveIncludes(const std::string& source, const std::string& dir,
+    const IncludeLoader& loader, std::set<std::string>& active, std::set<std::string>& included) {
+    static const std::regex includeRegex(R"(^\s*#\s*include\s+\"([^\"]+)\"\s*$)");
+
+    std::istringstream input(source);
+    std::string result;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(input, line)) {
+        lineNumber++;
+        std::smatch match;
+        if (line.find("include") == std::string::npos || !std::regex_match(line, match, includeRegex)) {
+            result += line + "\n";
+            continue;
+        }
+
+        const std::string name = dir + match[1].str();
+        if (active.count(name) > 0) {
+            throw std::runtime_error("Recursive shader include: \"" + name + "\"!");
+        }
+        if (!included.insert(name).second) {
+            result += "\n"; // every file is included once, like an implicit include guard
+            continue;
+        }
+        active.insert(name);
+        const std::size_t slash = name.find_last_of('/');
+        const std::string includeDir = slash == std::string::npos ? std::string() : name.substr(0, slash + 1);
+        result += "#line 1\n";
+        result += resolveIncludes(loader(name), includeDir, loader, active, included);
+        result += "#line " + std::to_string(lineNumber + 1) + "\n";
+        active.erase(name);
+    }
+    return result;
+}
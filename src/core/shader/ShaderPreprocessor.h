@@ -0,0 +1,32 @@
+#pragma once
+
+#include <functional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace OGL4Core2::Core {
+    /**
+     * Resolves #include "file" directives and injects #define lines after the #version line of a shader source, so
+     * constants like the FFT size or work group dimensions are known at compile time and shared code lives in one
+     * file. Every file is included at most once per program. #line directives keep the line numbers in compiler
+     * messages pointing at the original file.
+     */
+    class ShaderPreprocessor {
+    public:
+        using Defines = std::vector<std::pair<std::string, std::string>>;
+        // Returns the source of an include, name is relative to the directory of the top level shader.
+        using IncludeLoader = std::function<std::string(const std::string& name)>;
+
+        /** Throws std::runtime_error on malformed or recursive includes. */
+        static std::string process(const std::string& source, const Defines& defines, const IncludeLoader& loader);
+
+        /** The define block inserted by process(), also usable as a key for the variant. */
+        static std::string defineString(const Defines& defines);
+
+    private:
+        static std::string resolveIncludes(const std::string& source, const std::string& dir,
+            const IncludeLoader& loader, std::set<std::string>& active, std::set<std::string>& included);
+    };
+} // namespace OGL4Core2::Core
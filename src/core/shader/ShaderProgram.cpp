@@ -0,0 +1,157 @@
+#include "ShaderProgram.h"
+
+#include <algorithm>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "core/util/GLStateCache.h"
+
+using namespace OGL4Core2::Core;
+
+static std::string shaderTypeName(GLenum type) {
+    switch (type) {
+        case GL_VERTEX_SHADER:
+            return "vertex";
+        case GL_TESS_CONTROL_SHADER:
+            return "tessellation control";
+        case GL_TESS_EVALUATION_SHADER:
+            return "tessellation evaluation";
+        case GL_GEOMETRY_SHADER:
+            return "geometry";
+        case GL_FRAGMENT_SHADER:
+            return "fragment";
+        case GL_COMPUTE_SHADER:
+            return "compute";
+        default:
+            return "unknown";
+    }
+}
+
+ShaderProgram::ShaderProgram(GLuint handle) : handle_(handle), entry_(GpuMemoryLedger::add("Programs")) {}
+
+ShaderProgram::~ShaderProgram() {
+    GLStateCache::forgetProgram(handle_);
+    glDeleteProgram(handle_);
+    GpuMemoryLedger::remove(entry_);
+}
+
+GLuint ShaderProgram::compile(const ShaderSourceList& sources, bool retrievable) {
+    PendingCompile pending = beginCompile(sources, retrievable);
+    return finishCompile(pending);
+}
+
+ShaderProgram::PendingCompile ShaderProgram::beginCompile(const ShaderSourceList& sources, bool retrievable) {
+    PendingCompile pending{glCreateProgram(), {}};
+
+    for (const auto& [type, source] : sources) {
+        GLuint shader = glCreateShader(static_cast<GLenum>(type));
+        pending.shaders.push_back(shader);
+        const GLchar* src = source.c_str();
+        glShaderSource(shader, 1, &src, nullptr);
+        glCompileShader(shader);
+        glAttachShader(pending.program, shader);
+    }
+
+    if (retrievable) {
+        glProgramParameteri(pending.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(pending.program);
+    return pending;
+}
+
+GLuint ShaderProgram::finishCompile(PendingCompile& pending) {
+    for (GLuint shader : pending.shaders) {
+        GLint status = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+        if (status != GL_TRUE) {
+            GLint type = 0;
+            GLint length = 0;
+            glGetShaderiv(shader, GL_SHADER_TYPE, &type);
+            glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+            std::string log(std::max(length, 1), '\0');
+            glGetShaderInfoLog(shader, length, nullptr, log.data());
+            discardCompile(pending);
+            throw ShaderProgramException(
+                "Error compiling " + shaderTypeName(static_cast<GLenum>(type)) + " shader:\n" + log);
+        }
+    }
+
+    GLint status = GL_FALSE;
+    glGetProgramiv(pending.program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        GLint length = 0;
+        glGetProgramiv(pending.program, GL_INFO_LOG_LENGTH, &length);
+        std::string log(std::max(length, 1), '\0');
+        glGetProgramInfoLog(pending.program, length, nullptr, log.data());
+        discardCompile(pending);
+        throw ShaderProgramException("Error linking program:\n" + log);
+    }
+
+    for (GLuint shader : pending.shaders) {
+        glDetachShader(pending.program, shader);
+        glDeleteShader(shader);
+    }
+    pending.shaders.clear();
+    GLuint program = pending.program;
+    pending.program = 0;
+    return program;
+}
+
+void ShaderProgram::discardCompile(PendingCompile& pending) {
+    for (GLuint shader : pending.shaders) {
+        glDeleteShader(shader);
+    }
+    glDeleteProgram(pending.program);
+    pending.shaders.clear();
+    pending.program = 0;
+}
+
+void ShaderProgram::use() const {
+    GLStateCache::useProgram(handle_);
+}
+
+glm::ivec3 ShaderProgram::getWorkGroupSize() const {
+    glm::ivec3 size(0);
+    glGetProgramiv(handle_, GL_COMPUTE_WORK_GROUP_SIZE, glm::value_ptr(size));
+    return size;
+}
+
+void ShaderProgram::setUniform(const GLchar* name, bool v) const {
+    glProgramUniform1i(handle_, glGetUniformLocation(handle_, name), v ? 1 : 0);
+}
+
+void ShaderProgram::setUniform(const GLchar* name, int v) const {
+    glProgramUniform1i(handle_, glGetUniformLocation(handle_, name), v);
+}
+
+void ShaderProgram::setUniform(const GLchar* name, unsigned int v) const {
+    glProgramUniform1ui(handle_, glGetUniformLocation(handle_, name), v);
+}
+
+void ShaderProgram::setUniform(const GLchar* name, float v) const {
+    glProgramUniform1f(handle_, glGetUniformLocation(handle_, name), v);
+}
+
+void ShaderProgram::setUniform(const GLchar* name, const glm::vec2& v) const {
+    glProgramUniform2fv(handle_, glGetUniformLocation(handle_, name), 1, glm::value_ptr(v));
+}
+
+void ShaderProgram::setUniform(const GLchar* name, const glm::vec3& v) const {
+    glProgramUniform3fv(handle_, glGetUniformLocation(handle_, name), 1, glm::value_ptr(v));
+}
+
+void ShaderProgram::setUniform(const GLchar* name, const glm::vec4& v) const {
+    glProgramUniform4fv(handle_, glGetUniformLocation(handle_, name), 1, glm::value_ptr(v));
+}
+
+void ShaderProgram::setUniform(const GLchar* name, const glm::ivec2& v) const {
+    glProgramUniform2iv(handle_, glGetUniformLocation(handle_, name), 1, glm::value_ptr(v));
+}
+
+void ShaderProgram::setUniform(const GLchar* name, const glm::mat3& v) const {
+    glProgramUniformMatrix3fv(handle_, glGetUniformLocation(handle_, name), 1, GL_FALSE, glm::value_ptr(v));
+}
+
+void ShaderProgram::setUniform(const GLchar* name, const glm::mat4& v) const {
+    glProgramUniformMatrix4fv(handle_, glGetUniformLocation(handle_, name), 1, GL_FALSE, glm::value_ptr(v));
+}
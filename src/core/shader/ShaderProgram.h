@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <glowl/glowl.h>
+
+#include "core/util/GpuMemoryLedger.h"
+
+namespace OGL4Core2::Core {
+    class ShaderProgramException : public std::runtime_error {
+    public:
+        explicit ShaderProgramException(const std::string& msg) : std::runtime_error(msg) {}
+    };
+
+    /**
+     * Linked GLSL program, owns the program object. Unlike glowl::GLSLProgram it can be created from a program
+     * binary, which is what the ShaderCache needs. The interface follows glowl, so both can be used the same way.
+     */
+    class ShaderProgram {
+    public:
+        using ShaderType = glowl::GLSLProgram::ShaderType;
+        using ShaderSourceList = glowl::GLSLProgram::ShaderSourceList;
+
+        /** Takes ownership of a linked program object. */
+        explicit ShaderProgram(GLuint handle);
+        ~ShaderProgram();
+
+        ShaderProgram(const ShaderProgram&) = delete;
+        ShaderProgram(ShaderProgram&&) = delete;
+        ShaderProgram& operator=(const ShaderProgram&) = delete;
+        ShaderProgram& operator=(ShaderProgram&&) = delete;
+
+        /** Shader and program objects of a compile that was started but not checked yet. */
+        struct PendingCompile {
+            GLuint program;
+            std::vector<GLuint> shaders;
+        };
+
+        /**
+         * Compile and link the sources. Throws ShaderProgramException with the info log on errors. If retrievable
+         * is set, the driver is asked to keep the binary for glGetProgramBinary.
+         */
+        static GLuint compile(const ShaderSourceList& sources, bool retrievable = false);
+
+        /**
+         * Two halves of compile(). beginCompile() only issues the compile and link commands, so with
+         * KHR_parallel_shader_compile the driver works in the background until finishCompile() queries the results.
+         */
+        static PendingCompile beginCompile(const ShaderSourceList& sources, bool retrievable = false);
+        static GLuint finishCompile(PendingCompile& pending);
+        static void discardCompile(PendingCompile& pending);
+
+        /** Make the program current, skipped by the GLStateCache if it already is. */
+        void use() const;
+
+        /** Local work group size of a compute program, as declared by its layout qualifier. */
+        [[nodiscard]] glm::ivec3 getWorkGroupSize() const;
+
+        [[nodiscard]] inline GLuint getHandle() const {
+            return handle_;
+        }
+
+        void setUniform(const GLchar* name, bool v) const;
+        void setUniform(const GLchar* name, int v) const;
+        void setUniform(const GLchar* name, unsigned int v) const;
+        void setUniform(const GLchar* name, float v) const;
+        void setUniform(const GLchar* name, const glm::vec2& v) const;
+        void setUniform(const GLchar* name, const glm::vec3& v) const;
+        void setUniform(const GLchar* name, const glm::vec4& v) const;
+        void setUniform(const GLchar* name, const glm::ivec2& v) const;
+        void setUniform(const GLchar* name, const glm::mat3& v) const;
+        void setUniform(const GLchar* name, const glm::mat4& v) const;
+
+    private:
+        GLuint handle_;
+        GpuMemoryLedger::EntryId entry_;
+    };
+} // namespace OGL4Core2::Core
@@ -0,0 +1,89 @@
+#include "BindlessTextureTable.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// clang-format off
+#include <glad/gl.h>
+#include <GLFW/glfw3.h>
+// clang-format on
+
+using namespace OGL4Core2::Core;
+
+typedef GLuint64(GLAD_API_PTR* PFNGETTEXTURESAMPLERHANDLEARBPROC)(GLuint texture, GLuint sampler);
+typedef void(GLAD_API_PTR* PFNMAKETEXTUREHANDLERESIDENTARBPROC)(GLuint64 handle);
+typedef void(GLAD_API_PTR* PFNMAKETEXTUREHANDLENONRESIDENTARBPROC)(GLuint64 handle);
+
+namespace {
+    // ARB_bindless_texture, not loaded by glad
+    struct BindlessFunctions {
+        PFNGETTEXTURESAMPLERHANDLEARBPROC getTextureSamplerHandle = nullptr;
+        PFNMAKETEXTUREHANDLERESIDENTARBPROC makeResident = nullptr;
+        PFNMAKETEXTUREHANDLENONRESIDENTARBPROC makeNonResident = nullptr;
+        bool loaded = false;
+    };
+
+    const BindlessFunctions& functions() {
+        static BindlessFunctions f = []() {
+            BindlessFunctions result;
+            if (glfwExtensionSupported("GL_ARB_bindless_texture") != GLFW_TRUE) {
+                return result;
+            }
+            result.getTextureSamplerHandle = reinterpret_cast<PFNGETTEXTURESAMPLERHANDLEARBPROC>(
+                glfwGetProcAddress("glGetTextureSamplerHandleARB"));
+            result.makeResident = reinterpret_cast<PFNMAKETEXTUREHANDLERESIDENTARBPROC>(
+                glfwGetProcAddress("glMakeTextureHandleResidentARB"));
+            result.makeNonResident = reinterpret_cast<PFNMAKETEXTUREHANDLENONRESIDENTARBPROC>(
+                glfwGetProcAddress("glMakeTextureHandleNonResidentARB"));
+            result.loaded = result.getTextureSamplerHandle != nullptr && result.makeResident != nullptr &&
+                            result.makeNonResident != nullptr;
+            return result;
+        }();
+        return f;
+    }
+} // namespace
+
+bool BindlessTextureTable::supported() {
+    return functions().loaded;
+}
+
+BindlessTextureTable::BindlessTextureTable(std::size_t slots) : handles_(slots, 0), buffer_("Bindless") {
+    if (!supported()) {
+        throw std::runtime_error("ARB_bindless_texture is not supported!");
+    }
+    const auto bytes = static_cast<GLsizeiptr>(handles_.size() * sizeof(GLuint64));
+    glNamedBufferStorage(buffer_, bytes, handles_.data(), GL_DYNAMIC_STORAGE_BIT);
+    buffer_.setBytes(handles_.size() * sizeof(GLuint64));
+}
+
+BindlessTextureTable::~BindlessTextureTable() {
+    for (auto it = handles_.begin(); it != handles_.end(); ++it) {
+        // a handle in several slots is only resident once
+        if (*it != 0 && std::find(handles_.begin(), it, *it) == it) {
+            functions().makeNonResident(*it);
+        }
+    }
+}
+
+std::size_t BindlessTextureTable::slotsWith(GLuint64 handle) const {
+    return static_cast<std::size_t>(std::count(handles_.begin(), handles_.end(), handle));
+}
+
+void BindlessTextureTable::set(std::size_t slot, GLuint texture, GLuint sampler) {
+    // the same texture and sampler always return the same handle
+    const GLuint64 handle = functions().getTextureSamplerHandle(texture, sampler);
+    const GLuint64 previous = handles_.at(slot);
+    if (handle == previous) {
+        return;
+    }
+    handles_[slot] = handle;
+
+    // residency is not counted by GL, making a handle resident or non-resident twice is an error
+    if (previous != 0 && slotsWith(previous) == 0) {
+        functions().makeNonResident(previous);
+    }
+    if (slotsWith(handle) == 1) {
+        functions().makeResident(handle);
+    }
+    glNamedBufferSubData(buffer_, static_cast<GLintptr>(slot * sizeof(GLuint64)), sizeof(GLuint64), &handle);
+}
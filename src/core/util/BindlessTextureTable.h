@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/gl.h>
+
+#include "GLHandle.h"
+
+namespace OGL4Core2::Core {
+    /**
+     * Shader storage buffer of ARB_bindless_texture handles. Every slot holds the resident handle of a texture
+     * together with a sampler, shaders construct their samplers from the handles, so nothing has to be bound per
+     * draw. The state of a texture and sampler is frozen once they have a handle, so only textures with immutable
+     * storage should be added. The extension is not part of the glad profile, its functions are loaded on demand.
+     */
+    class BindlessTextureTable {
+    public:
+        /** True if the context supports ARB_bindless_texture and its functions could be loaded. */
+        [[nodiscard]] static bool supported();
+
+        /** Table with the given number of slots, all empty. */
+        explicit BindlessTextureTable(std::size_t slots);
+        /** Makes the handles of all slots non-resident, must run before the textures are deleted. */
+        ~BindlessTextureTable();
+
+        BindlessTextureTable(const BindlessTextureTable&) = delete;
+        BindlessTextureTable& operator=(const BindlessTextureTable&) = delete;
+
+        /**
+         * Make the handle of texture and sampler resident and store it in the slot. A handle held by several slots
+         * is made resident once and non-resident when the last of them is overwritten.
+         */
+        void set(std::size_t slot, GLuint texture, GLuint sampler);
+
+        [[nodiscard]] inline GLuint buffer() const {
+            return buffer_;
+        }
+
+    private:
+        [[nodiscard]] std::size_t slotsWith(GLuint64 handle) const;
+
+        std::vector<GLuint64> handles_;
+        BufferHandle buffer_;
+    };
+} // namespace OGL4Core2::Core
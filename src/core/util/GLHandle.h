@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#include <glad/gl.h>
+
+#include "GLStateCache.h"
+#include "GpuMemoryLedger.h"
+
+namespace OGL4Core2::Core {
+    enum class GLObjectType { Texture, Buffer, Sampler };
+
+    /**
+     * Owning handle of an OpenGL texture, buffer or sampler, deleted by the destructor. Every handle is registered
+     * in the GpuMemoryLedger under a category, setBytes() records the size of its storage. Handles convert to GLuint,
+     * so they can be passed to GL functions directly.
+     */
+    template<GLObjectType Type>
+    class GLHandle {
+    public:
+        /** Empty handle, no object. */
+        GLHandle() : name_(0), entry_(0) {}
+
+        /** Create a new buffer or sampler object. */
+        explicit GLHandle(const std::string& category) : name_(0), entry_(GpuMemoryLedger::add(category)) {
+            static_assert(Type != GLObjectType::Texture, "textures are created with a target");
+            if constexpr (Type == GLObjectType::Buffer) {
+                glCreateBuffers(1, &name_);
+            } else {
+                glCreateSamplers(1, &name_);
+            }
+        }
+
+        /**
+         * Create a new texture object for the given target. Unlike glGenTextures the object exists right away, so
+         * it can be used with the direct state access functions without binding it first.
+         */
+        GLHandle(GLenum target, const std::string& category) : name_(0), entry_(GpuMemoryLedger::add(category)) {
+            static_assert(Type == GLObjectType::Texture, "only textures are created with a target");
+            glCreateTextures(target, 1, &name_);
+        }
+
+        ~GLHandle() {
+            reset();
+        }
+
+        GLHandle(const GLHandle&) = delete;
+        GLHandle& operator=(const GLHandle&) = delete;
+
+        GLHandle(GLHandle&& other) noexcept : name_(other.name_), entry_(other.entry_) {
+            other.name_ = 0;
+            other.entry_ = 0;
+        }
+
+        GLHandle& operator=(GLHandle&& other) noexcept {
+            if (this != &other) {
+                reset();
+                std::swap(name_, other.name_);
+                std::swap(entry_, other.entry_);
+            }
+            return *this;
+        }
+
+        /** Delete the object, the handle is empty afterwards. */
+        void reset() {
+            if (name_ != 0) {
+                // the name may be reused for a new object, so it must not stay in the state cache
+                if constexpr (Type == GLObjectType::Texture) {
+                    GLStateCache::forgetTexture(name_);
+                    glDeleteTextures(1, &name_);
+                } else if constexpr (Type == GLObjectType::Buffer) {
+                    GLStateCache::forgetBuffer(name_);
+                    glDeleteBuffers(1, &name_);
+                } else {
+                    GLStateCache::forgetSampler(name_);
+                    glDeleteSamplers(1, &name_);
+                }
+                name_ = 0;
+            }
+            if (entry_ != 0) {
+                GpuMemoryLedger::remove(entry_);
+                entry_ = 0;
+            }
+        }
+
+        /** Size of the storage in bytes, for the ledger. */
+        void setBytes(std::size_t bytes) {
+            if (entry_ != 0) {
+                GpuMemoryLedger::resize(entry_, bytes);
+            }
+        }
+
+        [[nodiscard]] inline GLuint get() const {
+            return name_;
+        }
+
+        inline operator GLuint() const {
+            return name_;
+        }
+
+    private:
+        GLuint name_;
+        GpuMemoryLedger::EntryId entry_;
+    };
+
+    using TextureHandle = GLHandle<GLObjectType::Texture>;
+    using BufferHandle = GLHandle<GLObjectType::Buffer>;
+    using SamplerHandle = GLHandle<GLObjectType::Sampler>;
+} // namespace OGL4Core2::Core
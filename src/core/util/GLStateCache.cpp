@@ -0,0 +1,248 @@
+#include "GLStateCache.h"
+
+#include <imgui.h>
+
+using namespace OGL4Core2::Core;
+
+namespace {
+    // value of a binding that is not known, so the next call is always issued
+    constexpr GLuint unknown = 0xFFFFFFFFu;
+
+    // units above these limits are not cached, the calls are passed through
+    constexpr std::size_t maxTextureUnits = 32;
+    constexpr std::size_t maxImageUnits = 16;
+    constexpr std::size_t maxStorageBuffers = 16;
+
+    struct ImageBinding {
+        GLuint texture = unknown;
+        GLint level = 0;
+        GLboolean layered = GL_FALSE;
+        GLint layer = 0;
+        GLenum access = 0;
+        GLenum format = 0;
+
+        bool operator==(const ImageBinding& other) const {
+            return texture == other.texture && level == other.level && layered == other.layered &&
+                   layer == other.layer && access == other.access && format == other.format;
+        }
+    };
+
+    struct CacheState {
+        GLuint program = unknown;
+        std::array<GLuint, maxTextureUnits> textures;
+        std::array<GLuint, maxTextureUnits> samplers;
+        std::array<ImageBinding, maxImageUnits> images;
+        std::array<GLuint, maxStorageBuffers> storageBuffers;
+        GLenum polygonMode = unknown;
+        GLenum depthFunc = unknown;
+        int depthTest = -1;
+
+        GLStateCache::Counters frame;
+        GLStateCache::Counters lastFrame;
+
+        CacheState() {
+            reset();
+        }
+
+        void reset() {
+            program = unknown;
+            textures.fill(unknown);
+            samplers.fill(unknown);
+            images.fill(ImageBinding());
+            storageBuffers.fill(unknown);
+            polygonMode = unknown;
+            depthFunc = unknown;
+            depthTest = -1;
+        }
+    };
+
+    CacheState& state() {
+        static CacheState s;
+        return s;
+    }
+
+    // stores value in cached and returns true if the call has to be issued
+    template<typename T>
+    bool update(T& cached, const T& value, GLStateCache::Kind kind) {
+        const auto k = static_cast<std::size_t>(kind);
+        if (cached == value) {
+            state().frame.avoided[k]++;
+            return false;
+        }
+        cached = value;
+        state().frame.issued[k]++;
+        return true;
+    }
+
+    void passThrough(GLStateCache::Kind kind) {
+        state().frame.issued[static_cast<std::size_t>(kind)]++;
+    }
+
+    // multi-bind is issued once if any unit differs
+    bool updateRange(std::array<GLuint, maxTextureUnits>& cached, GLuint first, GLsizei count, const GLuint* names,
+        GLStateCache::Kind kind) {
+        const auto k = static_cast<std::size_t>(kind);
+        if (first + static_cast<std::size_t>(count) > maxTextureUnits) {
+            state().frame.issued[k]++;
+            return true;
+        }
+        bool changed = false;
+        for (GLsizei i = 0; i < count; i++) {
+            const GLuint name = names != nullptr ? names[i] : 0;
+            changed = changed || cached[first + i] != name;
+            cached[first + i] = name;
+        }
+        if (changed) {
+            state().frame.issued[k]++;
+        } else {
+            state().frame.avoided[k]++;
+        }
+        return changed;
+    }
+
+    const char* kindName(std::size_t kind) {
+        static const char* names[] = {"Program", "Texture", "Sampler", "Image", "Storage buffer", "Raster"};
+        return names[kind];
+    }
+} // namespace
+
+void GLStateCache::useProgram(GLuint program) {
+    if (update(state().program, program, Kind::Program)) {
+        glUseProgram(program);
+    }
+}
+
+void GLStateCache::bindTextureUnit(GLuint unit, GLuint texture) {
+    if (unit >= maxTextureUnits) {
+        passThrough(Kind::Texture);
+        glBindTextureUnit(unit, texture);
+    } else if (update(state().textures[unit], texture, Kind::Texture)) {
+        glBindTextureUnit(unit, texture);
+    }
+}
+
+void GLStateCache::bindSampler(GLuint unit, GLuint sampler) {
+    if (unit >= maxTextureUnits) {
+        passThrough(Kind::Sampler);
+        glBindSampler(unit, sampler);
+    } else if (update(state().samplers[unit], sampler, Kind::Sampler)) {
+        glBindSampler(unit, sampler);
+    }
+}
+
+void GLStateCache::bindTextures(GLuint first, GLsizei count, const GLuint* textures) {
+    if (updateRange(state().textures, first, count, textures, Kind::Texture)) {
+        glBindTextures(first, count, textures);
+    }
+}
+
+void GLStateCache::bindSamplers(GLuint first, GLsizei count, const GLuint* samplers) {
+    if (updateRange(state().samplers, first, count, samplers, Kind::Sampler)) {
+        glBindSamplers(first, count, samplers);
+    }
+}
+
+void GLStateCache::bindImageTexture(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer,
+    GLenum access, GLenum format) {
+    if (unit >= maxImageUnits) {
+        passThrough(Kind::Image);
+        glBindImageTexture(unit, texture, level, layered, layer, access, format);
+    } else if (update(state().images[unit], ImageBinding{texture, level, layered, layer, access, format},
+                   Kind::Image)) {
+        glBindImageTexture(unit, texture, level, layered, layer, access, format);
+    }
+}
+
+void GLStateCache::bindStorageBuffer(GLuint index, GLuint buffer) {
+    if (index >= maxStorageBuffers) {
+        passThrough(Kind::StorageBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, index, buffer);
+    } else if (update(state().storageBuffers[index], buffer, Kind::StorageBuffer)) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, index, buffer);
+    }
+}
+
+void GLStateCache::polygonMode(GLenum mode) {
+    if (update(state().polygonMode, mode, Kind::Raster)) {
+        glPolygonMode(GL_FRONT_AND_BACK, mode);
+    }
+}
+
+void GLStateCache::depthFunc(GLenum func) {
+    if (update(state().depthFunc, func, Kind::Raster)) {
+        glDepthFunc(func);
+    }
+}
+
+void GLStateCache::depthTest(bool enabled) {
+    if (update(state().depthTest, enabled ? 1 : 0, Kind::Raster)) {
+        if (enabled) {
+            glEnable(GL_DEPTH_TEST);
+        } else {
+            glDisable(GL_DEPTH_TEST);
+        }
+    }
+}
+
+void GLStateCache::forgetProgram(GLuint program) {
+    if (state().program == program) {
+        state().program = unknown;
+    }
+}
+
+void GLStateCache::forgetTexture(GLuint texture) {
+    for (GLuint& bound : state().textures) {
+        if (bound == texture) {
+            bound = unknown;
+        }
+    }
+    for (ImageBinding& image : state().images) {
+        if (image.texture == texture) {
+            image.texture = unknown;
+        }
+    }
+}
+
+void GLStateCache::forgetSampler(GLuint sampler) {
+    for (GLuint& bound : state().samplers) {
+        if (bound == sampler) {
+            bound = unknown;
+        }
+    }
+}
+
+void GLStateCache::forgetBuffer(GLuint buffer) {
+    for (GLuint& bound : state().storageBuffers) {
+        if (bound == buffer) {
+            bound = unknown;
+        }
+    }
+}
+
+void GLStateCache::invalidate() {
+    state().reset();
+}
+
+void GLStateCache::endFrame() {
+    state().lastFrame = state().frame;
+    state().frame = Counters();
+}
+
+const GLStateCache::Counters& GLStateCache::lastFrame() {
+    return state().lastFrame;
+}
+
+void GLStateCache::drawGUI() {
+    const Counters& c = lastFrame();
+    std::size_t issued = 0;
+    std::size_t avoided = 0;
+    for (std::size_t k = 0; k < c.issued.size(); k++) {
+        issued += c.issued[k];
+        avoided += c.avoided[k];
+    }
+    ImGui::Text("Last frame: %d calls issued, %d avoided", static_cast<int>(issued), static_cast<int>(avoided));
+    for (std::size_t k = 0; k < c.issued.size(); k++) {
+        ImGui::Text("%s: %d issued, %d avoided", kindName(k), static_cast<int>(c.issued[k]),
+            static_cast<int>(c.avoided[k]));
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include <glad/gl.h>
+
+namespace OGL4Core2::Core {
+    /**
+     * Shadow copy of the GL state that is rebound every frame: current program, texture and sampler units, image
+     * units, shader storage buffer bindings, polygon mode and depth state. Calls that would set the value that is
+     * already bound are filtered, issued and avoided calls are counted per frame.
+     *
+     * The cache is only correct if the state is not changed behind its back. ImGui restores everything it touches,
+     * the Core invalidates the cache when the plugin changes, code that binds directly has to call invalidate().
+     * Only used from the render thread, so it is not locked.
+     */
+    class GLStateCache {
+    public:
+        enum class Kind { Program, Texture, Sampler, Image, StorageBuffer, Raster, Count };
+
+        struct Counters {
+            std::array<std::size_t, static_cast<std::size_t>(Kind::Count)> issued{};
+            std::array<std::size_t, static_cast<std::size_t>(Kind::Count)> avoided{};
+        };
+
+        static void useProgram(GLuint program);
+        static void bindTextureUnit(GLuint unit, GLuint texture);
+        static void bindSampler(GLuint unit, GLuint sampler);
+        /** Multi-bind of consecutive units, a single GL call if any of them changed. */
+        static void bindTextures(GLuint first, GLsizei count, const GLuint* textures);
+        static void bindSamplers(GLuint first, GLsizei count, const GLuint* samplers);
+        static void bindImageTexture(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer,
+            GLenum access, GLenum format);
+        static void bindStorageBuffer(GLuint index, GLuint buffer);
+        /** Polygon mode of GL_FRONT_AND_BACK. */
+        static void polygonMode(GLenum mode);
+        static void depthFunc(GLenum func);
+        static void depthTest(bool enabled);
+
+        /** Called when an object is deleted, its name may be reused for a new object. */
+        static void forgetProgram(GLuint program);
+        static void forgetTexture(GLuint texture);
+        static void forgetSampler(GLuint sampler);
+        static void forgetBuffer(GLuint buffer);
+
+        /** Forget all cached state, the next call of every kind is issued. */
+        static void invalidate();
+
+        /** Called by the Core once per frame, moves the counters of the frame to lastFrame(). */
+        static void endFrame();
+        [[nodiscard]] static const Counters& lastFrame();
+
+        static void drawGUI();
+    };
+} // namespace OGL4Core2::Core
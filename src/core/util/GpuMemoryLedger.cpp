@@ -0,0 +1,114 @@
+#include "GpuMemoryLedger.h"
+
+#include <iostream>
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+#include <imgui.h>
+
+using namespace OGL4Core2::Core;
+
+namespace {
+    struct Entry {
+        std::string owner;
+        std::string category;
+        std::size_t bytes;
+    };
+
+    struct LedgerState {
+        std::unordered_map<GpuMemoryLedger::EntryId, Entry> entries;
+        GpuMemoryLedger::EntryId nextId = 1;
+        std::string owner = "Core";
+        std::size_t leaked = 0;
+    };
+
+    LedgerState& state() {
+        static LedgerState s;
+        return s;
+    }
+} // namespace
+
+GpuMemoryLedger::EntryId GpuMemoryLedger::add(const std::string& category, std::size_t bytes) {
+    LedgerState& s = state();
+    EntryId id = s.nextId++;
+    s.entries.emplace(id, Entry{s.owner, category, bytes});
+    return id;
+}
+
+void GpuMemoryLedger::resize(EntryId id, std::size_t bytes) {
+    auto it = state().entries.find(id);
+    if (it != state().entries.end()) {
+        it->second.bytes = bytes;
+    }
+}
+
+void GpuMemoryLedger::remove(EntryId id) {
+    state().entries.erase(id);
+}
+
+void GpuMemoryLedger::setOwner(const std::string& owner) {
+    state().owner = owner;
+}
+
+const std::string& GpuMemoryLedger::owner() {
+    return state().owner;
+}
+
+std::vector<GpuMemoryLedger::Usage> GpuMemoryLedger::usage() {
+    std::map<std::pair<std::string, std::string>, Usage> grouped;
+    for (const auto& [id, entry] : state().entries) {
+        Usage& u = grouped[{entry.owner, entry.category}];
+        u.owner = entry.owner;
+        u.category = entry.category;
+        u.objects++;
+        u.bytes += entry.bytes;
+    }
+    std::vector<Usage> result;
+    result.reserve(grouped.size());
+    for (auto& [key, u] : grouped) {
+        result.push_back(std::move(u));
+    }
+    return result;
+}
+
+std::size_t GpuMemoryLedger::leakedObjects() {
+    return state().leaked;
+}
+
+bool GpuMemoryLedger::checkReleased(const std::string& owner) {
+    bool released = true;
+    for (const Usage& u : usage()) {
+        if (u.owner != owner) {
+            continue;
+        }
+        std::cerr << "[GPU memory] " << owner << " leaked " << u.objects << " " << u.category << " object(s), "
+                  << u.bytes << " bytes" << std::endl;
+        state().leaked += u.objects;
+        released = false;
+    }
+    // keep leaked objects visible, but do not count them again when the owner is created another time
+    for (auto& [id, entry] : state().entries) {
+        if (entry.owner == owner) {
+            entry.owner = owner + " (leaked)";
+        }
+    }
+    return released;
+}
+
+void GpuMemoryLedger::drawGUI() {
+    std::size_t totalBytes = 0;
+    const std::vector<Usage> all = usage();
+    for (const Usage& u : all) {
+        totalBytes += u.bytes;
+    }
+    ImGui::Text("Live: %d objects, %.2f MB", static_cast<int>(state().entries.size()),
+        static_cast<double>(totalBytes) / (1024.0 * 1024.0));
+    if (state().leaked > 0) {
+        ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Leaked: %d objects", static_cast<int>(state().leaked));
+    }
+    for (const Usage& u : all) {
+        ImGui::Text("%s / %s: %d, %.2f MB", u.owner.c_str(), u.category.c_str(), static_cast<int>(u.objects),
+            static_cast<double>(u.bytes) / (1024.0 * 1024.0));
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace OGL4Core2::Core {
+    /**
+     * Process wide accounting of live OpenGL objects and their memory. Owning handles register themselves on
+     * creation, the owner is the plugin that was active at that time. The Core checks that a plugin released all of
+     * its objects when it is destroyed and reports leaks. Only used from the render thread, so it is not locked.
+     */
+    class GpuMemoryLedger {
+    public:
+        using EntryId = std::size_t;
+
+        struct Usage {
+            std::string owner;
+            std::string category;
+            std::size_t objects;
+            std::size_t bytes;
+        };
+
+        /** Register a new object with the current owner, returns the id for resize() and remove(). */
+        static EntryId add(const std::string& category, std::size_t bytes = 0);
+        static void resize(EntryId id, std::size_t bytes);
+        static void remove(EntryId id);
+
+        /** Owner of objects created from now on, set by the Core while a plugin is active. */
+        static void setOwner(const std::string& owner);
+        [[nodiscard]] static const std::string& owner();
+
+        /** Live objects and bytes grouped by owner and category, sorted by owner. */
+        [[nodiscard]] static std::vector<Usage> usage();
+        /** Objects still alive after their owner was destroyed, see checkReleased(). main() fails if nonzero. */
+        [[nodiscard]] static std::size_t leakedObjects();
+
+        /**
+         * Called after the owner was destroyed. Prints and counts the objects it did not release, returns true if
+         * everything was released.
+         */
+        static bool checkReleased(const std::string& owner);
+
+        static void drawGUI();
+    };
+} // namespace OGL4Core2::Core
@@ -0,0 +1,304 @@
+#include "Ktx2File.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include <lodepng.h>
+
+using namespace OGL4Core2::Core;
+
+namespace {
+    const unsigned char ktx2Identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+    constexpr std::size_t headerSize = 80; // identifier, header and index
+    constexpr std::size_t levelIndexEntrySize = 24;
+    constexpr std::size_t dfdSize = 44; // total size field, basic descriptor block and one sample
+    constexpr std::size_t bc1BlockSize = 8;
+
+    // KTX2 is little endian, as are all platforms OGL4Core2 runs on.
+    template<typename T>
+    T read(const unsigned char* data, std::size_t offset) {
+        T value;
+        std::memcpy(&value, data + offset, sizeof(T));
+        return value;
+    }
+
+    template<typename T>
+    void write(std::vector<unsigned char>& data, std::size_t offset, T value) {
+        std::memcpy(data.data() + offset, &value, sizeof(T));
+    }
+
+    std::size_t bc1ImageSize(int width, int height) {
+        return static_cast<std::size_t>((width + 3) / 4) * static_cast<std::size_t>((height + 3) / 4) * bc1BlockSize;
+    }
+
+    uint16_t toRgb565(const int c[3]) {
+        return static_cast<uint16_t>(((c[0] >> 3) << 11) | ((c[1] >> 2) << 5) | (c[2] >> 3));
+    }
+
+    void fromRgb565(uint16_t v, int c[3]) {
+        const int r = (v >> 11) & 0x1F;
+        const int g = (v >> 5) & 0x3F;
+        const int b = v & 0x1F;
+        c[0] = (r << 3) | (r >> 2);
+        c[1] = (g << 2) | (g >> 4);
+        c[2] = (b << 3) | (b >> 2);
+    }
+
+    /**
+     * Bounding box endpoints inset by 1/16 of the color range, as described by J.M.P. van Waveren in "Real-Time DXT
+     * Compression". Always uses the four color mode.
+     */
+    void compressBlock(const unsigned char block[64], unsigned char out[8]) {
+        int minColor[3] = {255, 255, 255};
+        int maxColor[3] = {0, 0, 0};
+        for (int i = 0; i < 16; i++) {
+            for (int c = 0; c < 3; c++) {
+                minColor[c] = std::min(minColor[c], int(block[4 * i + c]));
+                maxColor[c] = std::max(maxColor[c], int(block[4 * i + c]));
+            }
+        }
+        for (int c = 0; c < 3; c++) {
+            const int inset = (maxColor[c] - minColor[c]) >> 4;
+            minColor[c] = std::min(minColor[c] + inset, 255);
+            maxColor[c] = std::max(maxColor[c] - inset, 0);
+        }
+
+        uint16_t c0 = toRgb565(maxColor);
+        uint16_t c1 = toRgb565(minColor);
+        if (c0 < c1) {
+            std::swap(c0, c1);
+        }
+
+        uint32_t indices = 0;
+        if (c0 != c1) {
+            int palette[4][3];
+            fromRgb565(c0, palette[0]);
+            fromRgb565(c1, palette[1]);
+            for (int c = 0; c < 3; c++) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            for (int i = 0; i < 16; i++) {
+                int best = 0;
+                int bestDist = 3 * 256 * 256;
+                for (int p = 0; p < 4; p++) {
+                    int dist = 0;
+                    for (int c = 0; c < 3; c++) {
+                        const int d = int(block[4 * i + c]) - palette[p][c];
+                        dist += d * d;
+                    }
+                    if (dist < bestDist) {
+                        bestDist = dist;
+                        best = p;
+                    }
+                }
+                indices |= static_cast<uint32_t>(best) << (2 * i);
+            }
+        }
+
+        std::memcpy(out, &c0, 2);
+        std::memcpy(out + 2, &c1, 2);
+        std::memcpy(out + 4, &indices, 4);
+    }
+
+    std::vector<unsigned char> downsample(const std::vector<unsigned char>& src, int width, int height) {
+        const int w = std::max(width / 2, 1);
+        const int h = std::max(height / 2, 1);
+        std::vector<unsigned char> dst(static_cast<std::size_t>(w) * h * 4);
+        for (int y = 0; y < h; y++) {
+            const int y0 = std::min(2 * y, height - 1);
+            const int y1 = std::min(2 * y + 1, height - 1);
+            for (int x = 0; x < w; x++) {
+                const int x0 = std::min(2 * x, width - 1);
+                const int x1 = std::min(2 * x + 1, width - 1);
+                for (int c = 0; c < 4; c++) {
+                    const int sum = src[(static_cast<std::size_t>(y0) * width + x0) * 4 + c] +
+                                    src[(static_cast<std::size_t>(y0) * width + x1) * 4 + c] +
+                                    src[(static_cast<std::size_t>(y1) * width + x0) * 4 + c] +
+                                    src[(static_cast<std::size_t>(y1) * width + x1) * 4 + c];
+                    dst[(static_cast<std::size_t>(y) * w + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+                }
+            }
+        }
+        return dst;
+    }
+} // namespace
+
+Ktx2File::Ktx2File(const std::filesystem::path& path) : vkFormat_(0), width_(0), height_(0), faceCount_(0) {
+    file_ = std::make_unique<MappedFile>(path);
+    const unsigned char* data = file_->data();
+    const std::size_t size = file_->size();
+
+    if (size < headerSize || std::memcmp(data, ktx2Identifier, sizeof(ktx2Identifier)) != 0) {
+        throw std::runtime_error("File \"" + path.string() + "\" is not a KTX2 file!");
+    }
+    vkFormat_ = read<uint32_t>(data, 12);
+    width_ = static_cast<int>(read<uint32_t>(data, 20));
+    height_ = static_cast<int>(read<uint32_t>(data, 24));
+    const uint32_t depth = read<uint32_t>(data, 28);
+    const uint32_t layerCount = read<uint32_t>(data, 32);
+    faceCount_ = static_cast<int>(read<uint32_t>(data, 36));
+    const uint32_t levelCount = std::max(read<uint32_t>(data, 40), 1u);
+    const uint32_t supercompression = read<uint32_t>(data, 44);
+
+    if (vkFormat_ != VK_FORMAT_BC1_RGB_UNORM_BLOCK && vkFormat_ != VK_FORMAT_BC1_RGB_SRGB_BLOCK &&
+        vkFormat_ != VK_FORMAT_BC1_RGBA_UNORM_BLOCK) {
+        throw std::runtime_error("KTX2 file \"" + path.string() + "\" has unsupported format " +
+                                 std::to_string(vkFormat_) + "!");
+    }
+    if (depth > 1 || layerCount > 1 || supercompression != 0 || (faceCount_ != 1 && faceCount_ != 6)) {
+        throw std::runtime_error("KTX2 file \"" + path.string() + "\" is not a plain 2D texture or cubemap!");
+    }
+    if (size < headerSize + levelCount * levelIndexEntrySize) {
+        throw std::runtime_error("KTX2 file \"" + path.string() + "\" is truncated!");
+    }
+
+    for (uint32_t i = 0; i < levelCount; i++) {
+        const std::size_t entry = headerSize + i * levelIndexEntrySize;
+        Level level{static_cast<std::size_t>(read<uint64_t>(data, entry)),
+            static_cast<std::size_t>(read<uint64_t>(data, entry + 8))};
+        const int w = std::max(width_ >> i, 1);
+        const int h = std::max(height_ >> i, 1);
+        if (level.offset + level.size > size || level.size != bc1ImageSize(w, h) * faceCount_) {
+            throw std::runtime_error("KTX2 file \"" + path.string() + "\" has an invalid level " +
+                                     std::to_string(i) + "!");
+        }
+        levels_.push_back(level);
+    }
+}
+
+const unsigned char* Ktx2File::image(int level, int face) const {
+    return file_->data() + levels_.at(level).offset + face * imageSize(level);
+}
+
+std::size_t Ktx2File::imageSize(int level) const {
+    return levels_.at(level).size / faceCount_;
+}
+
+std::vector<unsigned char> Ktx2File::compressBC1(const unsigned char* rgba, int width, int height) {
+    std::vector<unsigned char> out(bc1ImageSize(width, height));
+    unsigned char block[64];
+    std::size_t offset = 0;
+    for (int by = 0; by < height; by += 4) {
+        for (int bx = 0; bx < width; bx += 4) {
+            for (int y = 0; y < 4; y++) {
+                for (int x = 0; x < 4; x++) {
+                    const int sx = std::min(bx + x, width - 1);
+                    const int sy = std::min(by + y, height - 1);
+                    std::memcpy(block + 4 * (4 * y + x), rgba + (static_cast<std::size_t>(sy) * width + sx) * 4, 4);
+                }
+            }
+            compressBlock(block, out.data() + offset);
+            offset += bc1BlockSize;
+        }
+    }
+    return out;
+}
+
+void Ktx2File::writeBC1Cubemap(const std::filesystem::path& path,
+    const std::array<std::vector<unsigned char>, 6>& faces, int width, int height) {
+
+    int levelCount = 1;
+    while ((std::max(width, height) >> levelCount) > 0) {
+        levelCount++;
+    }
+
+    // compressed faces of every level, level 0 first
+    std::vector<std::vector<unsigned char>> levels(levelCount);
+    for (const auto& face : faces) {
+        if (face.size() != static_cast<std::size_t>(width) * height * 4) {
+            throw std::runtime_error("Cubemap faces must have the same size!");
+        }
+        std::vector<unsigned char> image = face;
+        for (int level = 0; level < levelCount; level++) {
+            const int w = std::max(width >> level, 1);
+            const int h = std::max(height >> level, 1);
+            const std::vector<unsigned char> compressed = compressBC1(image.data(), w, h);
+            levels[level].insert(levels[level].end(), compressed.begin(), compressed.end());
+            if (level + 1 < levelCount) {
+                image = downsample(image, w, h);
+            }
+        }
+    }
+
+    // layout: header, level index, data format descriptor, then the levels from the smallest to the largest
+    const std::size_t dfdOffset = headerSize + levelCount * levelIndexEntrySize;
+    std::vector<std::size_t> levelOffsets(levelCount);
+    std::size_t fileSize = dfdOffset + dfdSize;
+    for (int level = levelCount - 1; level >= 0; level--) {
+        fileSize = (fileSize + bc1BlockSize - 1) / bc1BlockSize * bc1BlockSize;
+        levelOffsets[level] = fileSize;
+        fileSize += levels[level].size();
+    }
+
+    std::vector<unsigned char> out(fileSize, 0);
+    std::memcpy(out.data(), ktx2Identifier, sizeof(ktx2Identifier));
+    write<uint32_t>(out, 12, VK_FORMAT_BC1_RGB_UNORM_BLOCK);
+    write<uint32_t>(out, 16, 1); // typeSize
+    write<uint32_t>(out, 20, static_cast<uint32_t>(width));
+    write<uint32_t>(out, 24, static_cast<uint32_t>(height));
+    write<uint32_t>(out, 28, 0); // pixelDepth
+    write<uint32_t>(out, 32, 0); // layerCount
+    write<uint32_t>(out, 36, 6); // faceCount
+    write<uint32_t>(out, 40, static_cast<uint32_t>(levelCount));
+    write<uint32_t>(out, 44, 0); // no supercompression
+    write<uint32_t>(out, 48, static_cast<uint32_t>(dfdOffset));
+    write<uint32_t>(out, 52, static_cast<uint32_t>(dfdSize));
+    // no key/value data and no supercompression global data
+
+    for (int level = 0; level < levelCount; level++) {
+        const std::size_t entry = headerSize + level * levelIndexEntrySize;
+        write<uint64_t>(out, entry, levelOffsets[level]);
+        write<uint64_t>(out, entry + 8, levels[level].size());
+        write<uint64_t>(out, entry + 16, levels[level].size());
+        std::memcpy(out.data() + levelOffsets[level], levels[level].data(), levels[level].size());
+    }
+
+    // basic data format descriptor for BC1 RGB
+    write<uint32_t>(out, dfdOffset, static_cast<uint32_t>(dfdSize));
+    write<uint32_t>(out, dfdOffset + 4, 0);                    // vendor Khronos, basic descriptor type
+    write<uint32_t>(out, dfdOffset + 8, 2u | (40u << 16));     // version 2, block size 24 + 16 per sample
+    write<uint32_t>(out, dfdOffset + 12, 128u | (1u << 8) | (1u << 16)); // BC1A model, BT709, linear
+    write<uint32_t>(out, dfdOffset + 16, 3u | (3u << 8));      // 4x4 texel blocks
+    write<uint32_t>(out, dfdOffset + 20, bc1BlockSize);        // bytes in plane 0
+    write<uint32_t>(out, dfdOffset + 24, 0);
+    write<uint32_t>(out, dfdOffset + 28, 63u << 16);           // sample: bit offset 0, 64 bits, color channel
+    write<uint32_t>(out, dfdOffset + 32, 0);                   // sample position
+    write<uint32_t>(out, dfdOffset + 36, 0);                   // sample lower
+    write<uint32_t>(out, dfdOffset + 40, 0xFFFFFFFFu);         // sample upper
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot write KTX2 file \"" + path.string() + "\"!");
+    }
+    file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+    if (!file.good()) {
+        throw std::runtime_error("Cannot write KTX2 file \"" + path.string() + "\"!");
+    }
+}
+
+void Ktx2File::convertPngCubemap(const std::filesystem::path& dir, const std::filesystem::path& path) {
+    const char* names[6] = {"right.png", "left.png", "top.png", "bottom.png", "front.png", "back.png"};
+
+    std::array<std::vector<unsigned char>, 6> faces;
+    unsigned int width = 0;
+    unsigned int height = 0;
+    for (int i = 0; i < 6; i++) {
+        unsigned int w, h;
+        unsigned int error = lodepng::decode(faces[i], w, h, (dir / names[i]).string());
+        if (error != 0) {
+            std::string errorText = lodepng_error_text(error);
+            throw std::runtime_error("Cannot load PNG \"" + (dir / names[i]).string() + "\": " + errorText);
+        }
+        if (i > 0 && (w != width || h != height)) {
+            throw std::runtime_error("Cubemap faces must have the same size!");
+        }
+        width = w;
+        height = h;
+    }
+    writeBC1Cubemap(path, faces, static_cast<int>(width), static_cast<int>(height));
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "MappedFile.h"
+
+namespace OGL4Core2::Core {
+    /**
+     * KTX2 texture container with BC1 (DXT1) compressed images. The file is memory mapped, so the compressed images
+     * can be passed to glCompressedTexImage2D without an intermediate copy. Only unsupercompressed 2D textures and
+     * cubemaps are supported, which is what writeBC1Cubemap() produces.
+     */
+    class Ktx2File {
+    public:
+        static constexpr uint32_t VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131;
+        static constexpr uint32_t VK_FORMAT_BC1_RGB_SRGB_BLOCK = 132;
+        static constexpr uint32_t VK_FORMAT_BC1_RGBA_UNORM_BLOCK = 133;
+
+        explicit Ktx2File(const std::filesystem::path& path);
+
+        [[nodiscard]] inline uint32_t vkFormat() const {
+            return vkFormat_;
+        }
+        [[nodiscard]] inline int width() const {
+            return width_;
+        }
+        [[nodiscard]] inline int height() const {
+            return height_;
+        }
+        [[nodiscard]] inline int faceCount() const {
+            return faceCount_;
+        }
+        [[nodiscard]] inline int levelCount() const {
+            return static_cast<int>(levels_.size());
+        }
+
+        /** Compressed image of one face of a mip level. */
+        [[nodiscard]] const unsigned char* image(int level, int face) const;
+        [[nodiscard]] std::size_t imageSize(int level) const;
+
+        /**
+         * Compress six RGBA8 faces (order +X, -X, +Y, -Y, +Z, -Z) with a full box filtered mip chain to a BC1 KTX2
+         * cubemap.
+         */
+        static void writeBC1Cubemap(const std::filesystem::path& path,
+            const std::array<std::vector<unsigned char>, 6>& faces, int width, int height);
+
+        /** Convert a directory with right/left/top/bottom/front/back.png to a BC1 KTX2 cubemap. */
+        static void convertPngCubemap(const std::filesystem::path& dir, const std::filesystem::path& path);
+
+        /** BC1 compression of an RGBA8 image, blocks at the right and bottom border are padded by clamping. */
+        static std::vector<unsigned char> compressBC1(const unsigned char* rgba, int width, int height);
+
+    private:
+        struct Level {
+            std::size_t offset;
+            std::size_t size;
+        };
+
+        std::unique_ptr<MappedFile> file_;
+        uint32_t vkFormat_;
+        int width_;
+        int height_;
+        int faceCount_;
+        std::vector<Level> levels_;
+    };
+} // namespace OGL4Core2::Core
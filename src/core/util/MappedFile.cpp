@@ -0,0 +1,83 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX 1
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace OGL4Core2::Core;
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::filesystem::path& path)
+    : data_(nullptr),
+      size_(0),
+      file_(INVALID_HANDLE_VALUE),
+      mapping_(nullptr) {
+    file_ = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Cannot open file \"" + path.string() + "\" for mapping!");
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file_, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file_);
+        throw std::runtime_error("Cannot map empty file \"" + path.string() + "\"!");
+    }
+    size_ = static_cast<std::size_t>(fileSize.QuadPart);
+    mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_ == nullptr) {
+        CloseHandle(file_);
+        throw std::runtime_error("Cannot map file \"" + path.string() + "\"!");
+    }
+    data_ = static_cast<const unsigned char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (data_ == nullptr) {
+        CloseHandle(mapping_);
+        CloseHandle(file_);
+        throw std::runtime_error("Cannot map file \"" + path.string() + "\"!");
+    }
+}
+
+MappedFile::~MappedFile() {
+    UnmapViewOfFile(data_);
+    CloseHandle(mapping_);
+    CloseHandle(file_);
+}
+#else
+MappedFile::MappedFile(const std::filesystem::path& path) : data_(nullptr), size_(0), fd_(-1) {
+    fd_ = open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        throw std::runtime_error("Cannot open file \"" + path.string() + "\" for mapping!");
+    }
+    struct stat st {};
+    if (fstat(fd_, &st) != 0 || st.st_size == 0) {
+        close(fd_);
+        throw std::runtime_error("Cannot map empty file \"" + path.string() + "\"!");
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    void* ptr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (ptr == MAP_FAILED) {
+        close(fd_);
+        throw std::runtime_error("Cannot map file \"" + path.string() + "\"!");
+    }
+    // Playback reads the frames front to back.
+    madvise(ptr, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const unsigned char*>(ptr);
+}
+
+MappedFile::~MappedFile() {
+    munmap(const_cast<unsigned char*>(data_), size_);
+    close(fd_);
+}
+#endif
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+namespace OGL4Core2::Core {
+    /**
+     * Read-only memory mapping of a whole file. The mapping lives as long as the object, pages are loaded lazily by
+     * the operating system on first access.
+     */
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::filesystem::path& path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile(MappedFile&&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile& operator=(MappedFile&&) = delete;
+
+        [[nodiscard]] inline const unsigned char* data() const {
+            return data_;
+        }
+        [[nodiscard]] inline std::size_t size() const {
+            return size_;
+        }
+
+    private:
+        const unsigned char* data_;
+        std::size_t size_;
+#ifdef _WIN32
+        void* file_;
+        void* mapping_;
+#else
+        int fd_;
+#endif
+    };
+} // namespace OGL4Core2::Core
@@ -0,0 +1,40 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+using namespace OGL4Core2::Core;
+
+ThreadPool::ThreadPool(std::size_t threadCount) : stopping_(false) {
+    threadCount = std::max<std::size_t>(threadCount, 1);
+    workers_.reserve(threadCount);
+    for (std::size_t i = 0; i < threadCount; i++) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    condition_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return; // stopping and all work is done
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+        task(); // exceptions are stored in the future of the packaged task
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace OGL4Core2::Core {
+    /**
+     * Fixed size pool of worker threads for CPU work like file decoding. Tasks must not use OpenGL, the context is
+     * only current on the render thread. Pending tasks are finished before the destructor returns.
+     */
+    class ThreadPool {
+    public:
+        explicit ThreadPool(std::size_t threadCount);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool(ThreadPool&&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        ThreadPool& operator=(ThreadPool&&) = delete;
+
+        template<typename F>
+        std::future<std::invoke_result_t<std::decay_t<F>>> submit(F&& f) {
+            using R = std::invoke_result_t<std::decay_t<F>>;
+            auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+            std::future<R> future = task->get_future();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                tasks_.emplace([task]() { (*task)(); });
+            }
+            condition_.notify_one();
+            return future;
+        }
+
+        [[nodiscard]] inline std::size_t size() const {
+            return workers_.size();
+        }
+
+    private:
+        void workerLoop();
+
+        std::vector<std::thread> workers_;
+        std::queue<std::function<void()>> tasks_;
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        bool stopping_;
+    };
+} // namespace OGL4Core2::Core
@@ -1,12 +1,32 @@
 #include <exception>
 #include <iostream>
+#include <string>
 
 #include "core/Core.h"
+#include "core/util/GpuMemoryLedger.h"
+#include "core/util/Ktx2File.h"
 
-int main() {
+int main(int argc, char* argv[]) {
     try {
-        OGL4Core2::Core::Core c;
-        c.run();
+        // Offline conversion of PNG cubemaps to block compressed KTX2, e.g. for OceanSurface/resources/skybox1.
+        if (argc > 1 && std::string(argv[1]) == "--ktx2-cubemap") {
+            if (argc != 4) {
+                std::cerr << "Usage: " << argv[0] << " --ktx2-cubemap <png dir> <output.ktx2>" << std::endl;
+                return -1;
+            }
+            OGL4Core2::Core::Ktx2File::convertPngCubemap(argv[2], argv[3]);
+            return 0;
+        }
+        {
+            OGL4Core2::Core::Core c;
+            c.run();
+        }
+        // the Core checked every plugin it destroyed, a leak fails the run
+        if (OGL4Core2::Core::GpuMemoryLedger::leakedObjects() > 0) {
+            std::cerr << "OGL4Core2: " << OGL4Core2::Core::GpuMemoryLedger::leakedObjects()
+                      << " OpenGL object(s) leaked by plugins." << std::endl;
+            return 1;
+        }
     } catch (const std::exception& ex) {
         std::cerr << "OGL4Core2 Exception: " << ex.what() << std::endl;
         return -1;
@@ -0,0 +1,125 @@
+#include "BuoyancySystem.h"
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "core/util/GLStateCache.h"
+
+using namespace OGL4Core2;
+using namespace OGL4Core2::Plugins::PCVC::OceanSurface;
+
+static_assert(sizeof(BuoyancySystem::Body) == 20 * sizeof(float), "Body must match the std430 layout of the shader");
+
+/*
+ * @brief Allocate the state and instance buffers and build the cube all bodies share
+ */
+BuoyancySystem::BuoyancySystem(std::size_t capacity)
+    : bodyCapacity(capacity),
+      bodyCount(0),
+      ssboBodies("Bodies"),
+      ssboInstances("Body instances") {
+
+    const auto bodyBytes = GLsizeiptr(capacity * sizeof(Body));
+    const auto instanceBytes = GLsizeiptr(capacity * sizeof(glm::mat4));
+    glNamedBufferStorage(ssboBodies, bodyBytes, nullptr, GL_DYNAMIC_STORAGE_BIT); // rewritten by spawn()
+    ssboBodies.setBytes(size_t(bodyBytes));
+    glNamedBufferStorage(ssboInstances, instanceBytes, nullptr, 0);
+    ssboInstances.setBytes(size_t(instanceBytes));
+
+    // cube from -1 to 1 with flat normals, the instance matrix scales it by the half extents
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<GLuint> indices;
+    for (int axis = 0; axis < 3; axis++) {
+        for (float sign : {-1.0f, 1.0f}) {
+            glm::vec3 n(0.0f);
+            n[axis] = sign;
+            const glm::vec3 u(n[2], n[0], n[1]); // the other two axes, oriented so that cross(u, v) = n
+            const glm::vec3 v = glm::cross(n, u);
+            const auto base = GLuint(positions.size() / 3);
+            for (glm::vec2 c : {glm::vec2(-1, -1), glm::vec2(1, -1), glm::vec2(1, 1), glm::vec2(-1, 1)}) {
+                const glm::vec3 p = n + c.x * u + c.y * v;
+                positions.insert(positions.end(), {p.x, p.y, p.z});
+                normals.insert(normals.end(), {n.x, n.y, n.z});
+            }
+            indices.insert(indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+        }
+    }
+    glowl::Mesh::VertexDataList<float> vertexDataCube{
+        {positions, {12, {{3, GL_FLOAT, GL_FALSE, 0}}}},
+        {normals, {12, {{3, GL_FLOAT, GL_FALSE, 0}}}}};
+    vaCube = std::make_unique<glowl::Mesh>(vertexDataCube, indices, GL_UNSIGNED_INT, GL_TRIANGLES);
+}
+
+/*
+ * @brief Upload a new set of resting bodies, boxes of random proportions and yaw
+ */
+void BuoyancySystem::spawn(std::size_t count, glm::vec2 areaMin, glm::vec2 areaMax, float size, float density) {
+
+    if (count > bodyCapacity) {
+        throw std::invalid_argument("Body count exceeds the capacity of " + std::to_string(bodyCapacity));
+    }
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> x(areaMin.x, areaMax.x);
+    std::uniform_real_distribution<float> z(areaMin.y, areaMax.y);
+    std::uniform_real_distribution<float> extent(0.25f, 0.5f);
+    std::uniform_real_distribution<float> yaw(0.0f, glm::radians(360.0f));
+
+    std::vector<Body> bodies(count);
+    for (Body& body : bodies) {
+        const glm::vec3 halfExtents = size * glm::vec3(extent(rng), 0.5f * extent(rng), extent(rng));
+        const float mass = density * 8.0f * halfExtents.x * halfExtents.y * halfExtents.z;
+        const float angle = yaw(rng);
+        body.position = glm::vec4(x(rng), 0.0f, z(rng), mass);
+        body.orientation = glm::vec4(0.0f, std::sin(0.5f * angle), 0.0f, std::cos(0.5f * angle));
+        body.velocity = glm::vec4(0.0f);
+        body.angularVelocity = glm::vec4(0.0f);
+        body.halfExtents = glm::vec4(halfExtents, 0.0f);
+    }
+    if (count > 0)
+        glNamedBufferSubData(ssboBodies, 0, GLsizeiptr(count * sizeof(Body)), bodies.data());
+    bodyCount = count;
+}
+
+void BuoyancySystem::simulate(const Core::ShaderProgram& program, const OceanQuery::Surface& surface,
+    glm::vec2 wrapSize, const Params& params, float dt, GLuint texDispX, GLuint texDispY, GLuint texDispZ,
+    GLuint texNormalMap, GLuint wakeSources, std::size_t wakeCapacity) {
+
+    if (bodyCount == 0)
+        return;
+
+    program.use();
+    OceanQuery::bindSurface(program, surface, texDispX, texDispY, texDispZ, texNormalMap);
+    program.setUniform("bodyCount", int(bodyCount));
+    program.setUniform("dt", dt);
+    program.setUniform("gravity", params.gravity);
+    program.setUniform("waterDensity", params.waterDensity);
+    program.setUniform("linearDrag", params.linearDrag);
+    program.setUniform("angularDrag", params.angularDrag);
+    program.setUniform("wrapSize", wrapSize);
+    program.setUniform("wakeStrength", params.wakeStrength);
+    program.setUniform("wakeCapacity", unsigned(wakeSources != 0 ? wakeCapacity : 0));
+    if (wakeSources != 0)
+        Core::GLStateCache::bindStorageBuffer(10, wakeSources);
+    Core::GLStateCache::bindStorageBuffer(5, ssboBodies);
+    Core::GLStateCache::bindStorageBuffer(6, ssboInstances);
+
+    const glm::ivec3 size = program.getWorkGroupSize();
+    glDispatchCompute(GLuint((bodyCount + size_t(size.x) - 1) / size_t(size.x)), 1, 1);
+
+    // the vertex shader reads the matrices from the instance buffer, the wake solver the sources
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void BuoyancySystem::draw(const Core::ShaderProgram& program) const {
+
+    if (bodyCount == 0)
+        return;
+
+    program.use();
+    Core::GLStateCache::bindStorageBuffer(6, ssboInstances);
+    vaCube->draw(GLsizei(bodyCount));
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <glowl/glowl.h>
+
+#include "core/shader/ShaderProgram.h"
+#include "core/util/GLHandle.h"
+#include "OceanQuery.h"
+
+namespace OGL4Core2::Plugins::PCVC::OceanSurface {
+
+    /*
+     * @brief Floating boxes driven by the wave surface, simulated and drawn without a CPU round-trip
+     *
+     * The state of all bodies lives in a storage buffer. Buoyancy.comp samples eight points per box against the
+     * displaced surface like the height queries, integrates forces and torques and writes a model matrix per body
+     * into the instance buffer. Body.vert reads that buffer, so all bodies are drawn by one instanced draw call in
+     * the same frame.
+     */
+    class BuoyancySystem {
+    public:
+        // layout of one body in the state SSBO, std430
+        struct Body {
+            glm::vec4 position;        // xyz, mass in w
+            glm::vec4 orientation;     // quaternion (x, y, z, w)
+            glm::vec4 velocity;        // xyz
+            glm::vec4 angularVelocity; // xyz, world space
+            glm::vec4 halfExtents;     // xyz
+        };
+
+        struct Params {
+            float gravity;
+            float waterDensity; // body densities are relative to it
+            float linearDrag;   // per second while fully submerged
+            float angularDrag;
+            float wakeStrength; // height pushed down per unit of speed and second
+        };
+
+        // capacity is the largest body count spawn() accepts
+        explicit BuoyancySystem(std::size_t capacity);
+
+        // replace all bodies by count randomly placed boxes over the area, size is the edge length of the largest box
+        void spawn(std::size_t count, glm::vec2 areaMin, glm::vec2 areaMax, float size, float density);
+
+        // one integration step, the surface textures are RGBA32F with the value in .r; with a wake source buffer
+        // every body in the water appends a source to it, see WakeSolver
+        void simulate(const Core::ShaderProgram& program, const OceanQuery::Surface& surface, glm::vec2 wrapSize,
+            const Params& params, float dt, GLuint texDispX, GLuint texDispY, GLuint texDispZ, GLuint texNormalMap,
+            GLuint wakeSources = 0, std::size_t wakeCapacity = 0);
+
+        // draw all bodies with the matrices of the last step, the program is bound and has its camera uniforms
+        void draw(const Core::ShaderProgram& program) const;
+
+        [[nodiscard]] std::size_t count() const {
+            return bodyCount;
+        }
+        [[nodiscard]] std::size_t capacity() const {
+            return bodyCapacity;
+        }
+
+    private:
+        std::size_t bodyCapacity;
+        std::size_t bodyCount;
+
+        Core::BufferHandle ssboBodies;
+        Core::BufferHandle ssboInstances; // mat4 per body, written by the compute pass
+        std::unique_ptr<glowl::Mesh> vaCube;
+    };
+} // namespace OGL4Core2::Plugins::PCVC::OceanSurface
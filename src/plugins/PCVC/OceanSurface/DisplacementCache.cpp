@@ -0,0 +1,170 @@
+#include "DisplacementCache.h"
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+using namespace OGL4Core2;
+using namespace OGL4Core2::Plugins::PCVC::OceanSurface;
+
+static constexpr char cacheMagic[8] = {'O', 'C', 'E', 'A', 'N', 'L', 'P', '1'};
+static constexpr uint32_t cacheVersion = 1;
+static constexpr uint64_t chunkAlignment = 4096; // frames start at page boundaries for the mapping
+
+// half floats per texel: dispY, dispX, dispZ and the rgb normal
+static constexpr uint64_t channelsPerTexel = 6;
+static constexpr uint64_t maxResolution = 8192; // keeps the frame size arithmetic far from overflowing
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/*
+ * @brief Create the cache file and write a preliminary header
+ */
+DisplacementCacheWriter::DisplacementCacheWriter(const std::filesystem::path& path, int resolution, int frameCount,
+    float period)
+    : file(path, std::ios::binary | std::ios::trunc),
+      header{},
+      framesWritten(0) {
+
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot write displacement cache \"" + path.string() + "\"!");
+    }
+
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = cacheVersion;
+    header.resolution = uint32_t(resolution);
+    header.frameCount = uint32_t(frameCount);
+    header.period = period;
+    header.frameStride = alignUp(channelsPerTexel * sizeof(uint16_t) * uint64_t(resolution) * uint64_t(resolution),
+        chunkAlignment);
+    header.dataOffset = alignUp(sizeof(DisplacementCacheHeader), chunkAlignment);
+
+    staging.resize(header.frameStride / sizeof(uint16_t), 0);
+
+    // header is rewritten in finish() once the height range is known
+    std::vector<char> headerChunk(header.dataOffset, 0);
+    std::memcpy(headerChunk.data(), &header, sizeof(header));
+    file.write(headerChunk.data(), std::streamsize(headerChunk.size()));
+}
+
+/*
+ * @brief Read back the current simulation textures as half floats and append them as one frame chunk
+ */
+void DisplacementCacheWriter::writeFrame(GLuint texDispY, GLuint texDispX, GLuint texDispZ, GLuint texNormalMap) {
+
+    const size_t texels = size_t(header.resolution) * size_t(header.resolution);
+    uint16_t* dst = staging.data();
+
+    // the GL converts the RGBA32F textures to the packed half float layout
+    glPixelStorei(GL_PACK_ALIGNMENT, 2);
+    const GLuint singleChannel[3] = {texDispY, texDispX, texDispZ};
+    for (GLuint tex : singleChannel) {
+        glGetTextureImage(tex, 0, GL_RED, GL_HALF_FLOAT, GLsizei(texels * sizeof(uint16_t)), dst);
+        dst += texels;
+    }
+    glGetTextureImage(texNormalMap, 0, GL_RGB, GL_HALF_FLOAT, GLsizei(3 * texels * sizeof(uint16_t)), dst);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    file.write(reinterpret_cast<const char*>(staging.data()), std::streamsize(header.frameStride));
+    framesWritten++;
+}
+
+/*
+ * @brief Patch the header with the final frame count and height range
+ */
+void DisplacementCacheWriter::finish(float heightMax, float heightMin) {
+
+    header.frameCount = uint32_t(framesWritten);
+    header.heightMax = heightMax;
+    header.heightMin = heightMin;
+
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+
+    if (file.fail()) {
+        throw std::runtime_error("Writing the displacement cache failed!");
+    }
+}
+
+/*
+ * @brief Map the cache file and create the upload buffers
+ */
+DisplacementCache::DisplacementCache(const std::filesystem::path& path)
+    : file(std::make_unique<Core::MappedFile>(path)),
+      header{},
+      currentPbo(0),
+      currentFrame(-1) {
+
+    if (file->size() < sizeof(DisplacementCacheHeader)) {
+        throw std::runtime_error("Invalid displacement cache \"" + path.string() + "\"!");
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+
+    if (std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.version != cacheVersion) {
+        throw std::runtime_error("Unknown displacement cache format \"" + path.string() + "\"!");
+    }
+    // the layout follows from the resolution, a header that disagrees would make the uploads read past the mapping
+    const uint64_t res = header.resolution;
+    if (res == 0 || res > maxResolution || header.frameCount == 0 || header.period <= 0.0f ||
+        header.frameStride != alignUp(channelsPerTexel * sizeof(uint16_t) * res * res, chunkAlignment) ||
+        header.dataOffset != alignUp(sizeof(DisplacementCacheHeader), chunkAlignment)) {
+        throw std::runtime_error("Invalid displacement cache \"" + path.string() + "\"!");
+    }
+    if (header.dataOffset + header.frameStride * header.frameCount != file->size()) {
+        throw std::runtime_error("Truncated displacement cache \"" + path.string() + "\"!");
+    }
+
+    // two buffers, so filling the next frame never waits for the upload of the previous one. Every frame has the
+    // same size, so the buffers get immutable storage that is only ever mapped for writing.
+    for (Core::BufferHandle& buffer : pbo) {
+        buffer = Core::BufferHandle("Streaming");
+        glNamedBufferStorage(buffer, GLsizeiptr(header.frameStride), nullptr, GL_MAP_WRITE_BIT);
+        buffer.setBytes(header.frameStride);
+    }
+}
+
+DisplacementCache::~DisplacementCache() = default;
+
+/*
+ * @brief Upload the frame belonging to the given time, skips the upload if the frame did not change
+ */
+bool DisplacementCache::upload(float time, GLuint texDispY, GLuint texDispX, GLuint texDispZ, GLuint texNormalMap) {
+
+    float loopTime = std::fmod(time, header.period);
+    int frame = int(loopTime / header.period * float(header.frameCount)) % int(header.frameCount);
+    if (frame == currentFrame)
+        return false;
+    currentFrame = frame;
+
+    const unsigned char* src = file->data() + header.dataOffset + header.frameStride * uint64_t(frame);
+
+    currentPbo = (currentPbo + 1) % 2;
+    void* dst = glMapNamedBufferRange(pbo[currentPbo], 0, GLsizeiptr(header.frameStride),
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (dst == nullptr) {
+        return false;
+    }
+    std::memcpy(dst, src, header.frameStride);
+    glUnmapNamedBuffer(pbo[currentPbo]);
+
+    const GLsizei N = GLsizei(header.resolution);
+    const size_t channelBytes = size_t(N) * size_t(N) * sizeof(uint16_t);
+
+    // with a bound unpack buffer the data pointer is an offset into the PBO
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo[currentPbo]);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+    const GLuint singleChannel[3] = {texDispY, texDispX, texDispZ};
+    for (int i = 0; i < 3; i++) {
+        glTextureSubImage2D(singleChannel[i], 0, 0, 0, N, N, GL_RED, GL_HALF_FLOAT,
+            reinterpret_cast<const void*>(channelBytes * size_t(i)));
+    }
+    glTextureSubImage2D(texNormalMap, 0, 0, 0, N, N, GL_RGB, GL_HALF_FLOAT,
+        reinterpret_cast<const void*>(channelBytes * 3));
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return true;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include <glad/gl.h>
+
+#include "core/util/GLHandle.h"
+#include "core/util/MappedFile.h"
+
+namespace OGL4Core2::Plugins::PCVC::OceanSurface {
+
+    /*
+     * File layout of a baked loop: a fixed header followed by one chunk per frame. Each chunk stores the fields as
+     * half floats in upload order: dispY, dispX, dispZ (one channel each) and the normal map (rgb).
+     */
+    struct DisplacementCacheHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t resolution;
+        uint32_t frameCount;
+        float period;
+        float heightMax;
+        float heightMin;
+        uint64_t frameStride;
+        uint64_t dataOffset;
+    };
+    static_assert(sizeof(DisplacementCacheHeader) == 48);
+
+    /*
+     * @brief Writes the simulation output of one loop period frame by frame into a cache file
+     */
+    class DisplacementCacheWriter {
+    public:
+        DisplacementCacheWriter(const std::filesystem::path& path, int resolution, int frameCount, float period);
+
+        void writeFrame(GLuint texDispY, GLuint texDispX, GLuint texDispZ, GLuint texNormalMap);
+        void finish(float heightMax, float heightMin);
+
+    private:
+        std::ofstream file;
+        DisplacementCacheHeader header;
+        std::vector<uint16_t> staging;
+        int framesWritten;
+    };
+
+    /*
+     * @brief Plays back a baked loop from a memory mapped cache file, uploading one frame per tick through PBOs
+     */
+    class DisplacementCache {
+    public:
+        explicit DisplacementCache(const std::filesystem::path& path);
+        ~DisplacementCache();
+
+        DisplacementCache(const DisplacementCache&) = delete;
+        DisplacementCache& operator=(const DisplacementCache&) = delete;
+
+        [[nodiscard]] int resolution() const {
+            return int(header.resolution);
+        }
+        [[nodiscard]] int frameCount() const {
+            return int(header.frameCount);
+        }
+        [[nodiscard]] float period() const {
+            return header.period;
+        }
+        [[nodiscard]] float heightMax() const {
+            return header.heightMax;
+        }
+        [[nodiscard]] float heightMin() const {
+            return header.heightMin;
+        }
+
+        // returns true if a new frame was uploaded
+        bool upload(float time, GLuint texDispY, GLuint texDispX, GLuint texDispZ, GLuint texNormalMap);
+
+    private:
+        std::unique_ptr<Core::MappedFile> file;
+        DisplacementCacheHeader header;
+        Core::BufferHandle pbo[2];
+        int currentPbo;
+        int currentFrame;
+    };
+} // namespace OGL4Core2::Plugins::PCVC::OceanSurface
@@ -0,0 +1,302 @@
+#include "DisplacementMirror.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define MIRROR_AVX2 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define MIRROR_TARGET_AVX2
+#else
+#define MIRROR_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+using namespace OGL4Core2;
+using namespace OGL4Core2::Plugins::PCVC::OceanSurface;
+
+namespace {
+    // field and surface mapping in the form the samplers need
+    struct SampleParams {
+        const float* dispX;
+        const float* dispY;
+        const float* dispZ;
+        int mask;  // resolution - 1
+        int shift; // log2 of the resolution, row stride
+        float originX;
+        float originZ;
+        float invTexelSize;
+        float choppiness;
+        float waveHeight;
+        int iterations;
+    };
+
+    float bilinear(const float* data, int mask, int shift, float u, float v) {
+        const float fu = std::floor(u);
+        const float fv = std::floor(v);
+        const float tu = u - fu;
+        const float tv = v - fv;
+        // the patch is periodic, masking wraps negative indices as well
+        const int u0 = int(fu) & mask;
+        const int v0 = int(fv) & mask;
+        const int u1 = (u0 + 1) & mask;
+        const int v1 = (v0 + 1) & mask;
+        const float a = data[(v0 << shift) + u0] + tu * (data[(v0 << shift) + u1] - data[(v0 << shift) + u0]);
+        const float b = data[(v1 << shift) + u0] + tu * (data[(v1 << shift) + u1] - data[(v1 << shift) + u0]);
+        return a + tv * (b - a);
+    }
+
+    // same fixed point inversion of the choppy offset as OceanQuery.comp
+    void sampleScalar(const SampleParams& p, const glm::vec2* points, std::size_t count, float* heights) {
+        for (std::size_t i = 0; i < count; i++) {
+            float x = points[i].x;
+            float z = points[i].y;
+            for (int k = 0; k < p.iterations; k++) {
+                const float u = (x - p.originX) * p.invTexelSize;
+                const float v = (z - p.originZ) * p.invTexelSize;
+                x = points[i].x + p.choppiness * bilinear(p.dispX, p.mask, p.shift, u, v);
+                z = points[i].y + p.choppiness * bilinear(p.dispZ, p.mask, p.shift, u, v);
+            }
+            const float u = (x - p.originX) * p.invTexelSize;
+            const float v = (z - p.originZ) * p.invTexelSize;
+            heights[i] = p.waveHeight * bilinear(p.dispY, p.mask, p.shift, u, v);
+        }
+    }
+
+#ifdef MIRROR_AVX2
+    MIRROR_TARGET_AVX2 inline __m256 bilinear8(const float* data, __m256i mask, int shift, __m256 u, __m256 v) {
+        const __m256 fu = _mm256_floor_ps(u);
+        const __m256 fv = _mm256_floor_ps(v);
+        const __m256 tu = _mm256_sub_ps(u, fu);
+        const __m256 tv = _mm256_sub_ps(v, fv);
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i u0 = _mm256_and_si256(_mm256_cvttps_epi32(fu), mask);
+        const __m256i v0 = _mm256_and_si256(_mm256_cvttps_epi32(fv), mask);
+        const __m256i u1 = _mm256_and_si256(_mm256_add_epi32(u0, one), mask);
+        const __m256i row0 = _mm256_slli_epi32(v0, shift);
+        const __m256i row1 = _mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(v0, one), mask), shift);
+
+        const __m256 d00 = _mm256_i32gather_ps(data, _mm256_add_epi32(row0, u0), 4);
+        const __m256 d10 = _mm256_i32gather_ps(data, _mm256_add_epi32(row0, u1), 4);
+        const __m256 d01 = _mm256_i32gather_ps(data, _mm256_add_epi32(row1, u0), 4);
+        const __m256 d11 = _mm256_i32gather_ps(data, _mm256_add_epi32(row1, u1), 4);
+        const __m256 a = _mm256_fmadd_ps(tu, _mm256_sub_ps(d10, d00), d00);
+        const __m256 b = _mm256_fmadd_ps(tu, _mm256_sub_ps(d11, d01), d01);
+        return _mm256_fmadd_ps(tv, _mm256_sub_ps(b, a), a);
+    }
+
+    MIRROR_TARGET_AVX2 void sampleAvx2(const SampleParams& p, const glm::vec2* points, std::size_t count,
+        float* heights) {
+        const __m256i mask = _mm256_set1_epi32(p.mask);
+        const __m256 originX = _mm256_set1_ps(p.originX);
+        const __m256 originZ = _mm256_set1_ps(p.originZ);
+        const __m256 invTexelSize = _mm256_set1_ps(p.invTexelSize);
+        const __m256 choppiness = _mm256_set1_ps(p.choppiness);
+        const __m256 waveHeight = _mm256_set1_ps(p.waveHeight);
+
+        std::size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            // deinterleave 8 (x, z) pairs, the shuffle works per 128 bit lane and the permute restores the order
+            const float* src = &points[i].x;
+            const __m256 a = _mm256_loadu_ps(src);
+            const __m256 b = _mm256_loadu_ps(src + 8);
+            const __m256 targetX = _mm256_castpd_ps(_mm256_permute4x64_pd(
+                _mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0)));
+            const __m256 targetZ = _mm256_castpd_ps(_mm256_permute4x64_pd(
+                _mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0)));
+
+            __m256 x = targetX;
+            __m256 z = targetZ;
+            for (int k = 0; k < p.iterations; k++) {
+                const __m256 u = _mm256_mul_ps(_mm256_sub_ps(x, originX), invTexelSize);
+                const __m256 v = _mm256_mul_ps(_mm256_sub_ps(z, originZ), invTexelSize);
+                x = _mm256_fmadd_ps(choppiness, bilinear8(p.dispX, mask, p.shift, u, v), targetX);
+                z = _mm256_fmadd_ps(choppiness, bilinear8(p.dispZ, mask, p.shift, u, v), targetZ);
+            }
+            const __m256 u = _mm256_mul_ps(_mm256_sub_ps(x, originX), invTexelSize);
+            const __m256 v = _mm256_mul_ps(_mm256_sub_ps(z, originZ), invTexelSize);
+            _mm256_storeu_ps(heights + i, _mm256_mul_ps(waveHeight, bilinear8(p.dispY, mask, p.shift, u, v)));
+        }
+        sampleScalar(p, points + i, count - i, heights + i);
+    }
+#endif
+} // namespace
+
+/*
+ * @brief Pack buffer for the three displacement textures, the readback starts with the first update
+ */
+DisplacementMirror::DisplacementMirror(int resolution)
+    : resolution(resolution),
+      interval(4),
+      downsample(1),
+      frameCounter(0),
+      lastReadback(0),
+      pbo("Streaming"),
+      fence(nullptr),
+      pendingSurface{} {
+
+    if (resolution <= 0 || (resolution & (resolution - 1)) != 0) {
+        throw std::invalid_argument("The displacement mirror needs a power of two resolution!");
+    }
+    const size_t bytes = 3 * size_t(resolution) * size_t(resolution) * sizeof(float);
+    glNamedBufferStorage(pbo, GLsizeiptr(bytes), nullptr, GL_MAP_READ_BIT);
+    pbo.setBytes(bytes);
+}
+
+DisplacementMirror::~DisplacementMirror() {
+
+    if (fence != nullptr)
+        glDeleteSync(fence);
+}
+
+bool DisplacementMirror::avx2Supported() {
+#if defined(MIRROR_AVX2) && defined(_MSC_VER) && !defined(__clang__)
+    static const bool supported = []() {
+        int info[4];
+        __cpuid(info, 1);
+        const bool fma = (info[2] & (1 << 12)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        __cpuidex(info, 7, 0);
+        const bool avx2 = (info[1] & (1 << 5)) != 0;
+        // the OS has to save the ymm registers
+        return fma && avx2 && osxsave && (_xgetbv(0) & 6) == 6;
+    }();
+    return supported;
+#elif defined(MIRROR_AVX2)
+    static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+/*
+ * @brief Publish a finished readback and start the next one when the interval passed
+ */
+void DisplacementMirror::update(GLuint texDispX, GLuint texDispY, GLuint texDispZ,
+    const OceanQuery::Surface& surface) {
+
+    frameCounter++;
+
+    if (fence != nullptr) {
+        const GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            return;
+        glDeleteSync(fence);
+        fence = nullptr;
+
+        const size_t bytes = 3 * size_t(resolution) * size_t(resolution) * sizeof(float);
+        const auto* data = static_cast<const float*>(glMapNamedBufferRange(pbo, 0, GLsizeiptr(bytes), GL_MAP_READ_BIT));
+        if (data != nullptr) {
+            publish(data);
+            glUnmapNamedBuffer(pbo);
+        }
+    }
+
+    if (frameCounter - lastReadback < uint64_t(interval) && std::atomic_load(&front) != nullptr)
+        return;
+
+    // with a bound pack buffer the data pointer is an offset into the PBO
+    const size_t channelBytes = size_t(resolution) * size_t(resolution) * sizeof(float);
+    const GLuint textures[3] = {texDispX, texDispY, texDispZ};
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+    for (int i = 0; i < 3; i++) {
+        glGetTextureImage(textures[i], 0, GL_RED, GL_FLOAT, GLsizei(channelBytes),
+            reinterpret_cast<void*>(channelBytes * size_t(i)));
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    pendingSurface = surface;
+    lastReadback = frameCounter;
+}
+
+/*
+ * @brief Copy the mapped readback into a new field, keeping every downsample-th texel
+ */
+void DisplacementMirror::publish(const float* data) {
+
+    auto field = std::make_shared<Field>();
+    field->resolution = resolution / downsample;
+    field->surface = pendingSurface;
+    field->surface.texelSize *= float(downsample);
+    field->frame = lastReadback;
+
+    const size_t texels = size_t(field->resolution) * size_t(field->resolution);
+    std::vector<float>* channels[3] = {&field->dispX, &field->dispY, &field->dispZ};
+    for (int c = 0; c < 3; c++) {
+        const float* src = data + size_t(c) * size_t(resolution) * size_t(resolution);
+        std::vector<float>& dst = *channels[c];
+        dst.resize(texels);
+        for (int j = 0; j < field->resolution; j++) {
+            for (int i = 0; i < field->resolution; i++) {
+                dst[size_t(j) * size_t(field->resolution) + size_t(i)] =
+                    src[size_t(j * downsample) * size_t(resolution) + size_t(i * downsample)];
+            }
+        }
+    }
+    std::atomic_store(&front, std::shared_ptr<const Field>(std::move(field)));
+}
+
+std::shared_ptr<const DisplacementMirror::Field> DisplacementMirror::field() const {
+    return std::atomic_load(&front);
+}
+
+void DisplacementMirror::sampleHeight(const glm::vec2* points, std::size_t count, float* heights) const {
+    sample(points, count, heights, avx2Supported());
+}
+
+void DisplacementMirror::sampleHeightScalar(const glm::vec2* points, std::size_t count, float* heights) const {
+    sample(points, count, heights, false);
+}
+
+void DisplacementMirror::sample(const glm::vec2* points, std::size_t count, float* heights, bool avx2) const {
+
+    const std::shared_ptr<const Field> f = field();
+    if (f == nullptr) {
+        std::fill(heights, heights + count, 0.0f);
+        return;
+    }
+
+    SampleParams p{};
+    p.dispX = f->dispX.data();
+    p.dispY = f->dispY.data();
+    p.dispZ = f->dispZ.data();
+    p.mask = f->resolution - 1;
+    p.shift = int(std::lround(std::log2(f->resolution)));
+    p.originX = f->surface.origin.x;
+    p.originZ = f->surface.origin.y;
+    p.invTexelSize = 1.0f / f->surface.texelSize;
+    p.choppiness = f->surface.choppiness;
+    p.waveHeight = f->surface.waveHeight;
+    p.iterations = f->surface.iterations;
+
+#ifdef MIRROR_AVX2
+    if (avx2) {
+        sampleAvx2(p, points, count, heights);
+        return;
+    }
+#else
+    (void)avx2;
+#endif
+    sampleScalar(p, points, count, heights);
+}
+
+void DisplacementMirror::sampleHeight(const std::vector<glm::vec2>& points, std::vector<float>& heights) const {
+    heights.resize(points.size());
+    sampleHeight(points.data(), points.size(), heights.data());
+}
+
+void DisplacementMirror::setInterval(int frames) {
+    interval = std::max(frames, 1);
+}
+
+void DisplacementMirror::setDownsample(int factor) {
+    // the downsampled field has to stay a power of two
+    int power = 1;
+    while (power * 2 <= factor && power * 2 < resolution)
+        power *= 2;
+    downsample = power;
+}
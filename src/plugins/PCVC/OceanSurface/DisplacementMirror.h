@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "core/util/GLHandle.h"
+#include "OceanQuery.h"
+
+namespace OGL4Core2::Plugins::PCVC::OceanSurface {
+
+    /*
+     * @brief CPU copy of the displacement field for height queries without GPU latency
+     *
+     * Every few frames the displacement textures are copied into a pixel pack buffer, the copy is mapped once its
+     * fence signaled, so the render thread never waits. The field is optionally downsampled and published as an
+     * immutable snapshot, sampleHeight() can be called from any thread and always sees a complete field. The
+     * sampler resolves the choppy offset like OceanQuery.comp; with AVX2 eight points are processed at once with
+     * gathers, the CPU is checked at runtime.
+     */
+    class DisplacementMirror {
+    public:
+        // one published field, the surface mapping is the one of the frame it was read back in
+        struct Field {
+            int resolution;
+            OceanQuery::Surface surface; // texelSize is scaled by the downsampling
+            std::vector<float> dispX;
+            std::vector<float> dispY;
+            std::vector<float> dispZ;
+            uint64_t frame; // frame of the readback
+        };
+
+        // resolution of the textures, must be a power of two like the FFT
+        explicit DisplacementMirror(int resolution);
+        ~DisplacementMirror();
+
+        DisplacementMirror(const DisplacementMirror&) = delete;
+        DisplacementMirror& operator=(const DisplacementMirror&) = delete;
+
+        // called once per frame after the simulation, starts a readback every interval frames
+        void update(GLuint texDispX, GLuint texDispY, GLuint texDispZ, const OceanQuery::Surface& surface);
+
+        // heights of the surface above the points, 0 until the first field arrived; thread safe
+        void sampleHeight(const glm::vec2* points, std::size_t count, float* heights) const;
+        void sampleHeight(const std::vector<glm::vec2>& points, std::vector<float>& heights) const;
+        // the same without AVX2, the reference the vectorized path is checked against
+        void sampleHeightScalar(const glm::vec2* points, std::size_t count, float* heights) const;
+
+        // current snapshot, null until the first readback finished; thread safe
+        [[nodiscard]] std::shared_ptr<const Field> field() const;
+
+        void setInterval(int frames);
+        // every factor-th texel is kept, a power of two
+        void setDownsample(int factor);
+
+        [[nodiscard]] uint64_t frame() const {
+            return frameCounter;
+        }
+        [[nodiscard]] static bool avx2Supported();
+
+    private:
+        void publish(const float* data);
+        void sample(const glm::vec2* points, std::size_t count, float* heights, bool avx2) const;
+
+        int resolution;
+        int interval;
+        int downsample;
+        uint64_t frameCounter;
+        uint64_t lastReadback;
+
+        Core::BufferHandle pbo;
+        GLsync fence;
+        OceanQuery::Surface pendingSurface;
+
+        std::shared_ptr<const Field> front; // accessed with std::atomic_load/atomic_store
+    };
+} // namespace OGL4Core2::Plugins::PCVC::OceanSurface
@@ -0,0 +1,190 @@
+#include "GaussianRng.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <smmintrin.h>
+#define GAUSSIAN_SSE41 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define GAUSSIAN_TARGET_SSE41
+#else
+#define GAUSSIAN_TARGET_SSE41 __attribute__((target("sse4.1")))
+#endif
+#endif
+
+using namespace OGL4Core2::Plugins::PCVC::OceanSurface;
+
+static constexpr uint32_t philoxM0 = 0xD2511F53u;
+static constexpr uint32_t philoxM1 = 0xCD9E8D57u;
+static constexpr uint32_t philoxW0 = 0x9E3779B9u;
+static constexpr uint32_t philoxW1 = 0xBB67AE85u;
+static constexpr int philoxRounds = 10;
+
+static constexpr float twoPi = 6.283185307179586f;
+
+/*
+ * @brief Philox4x32 with 10 rounds
+ */
+std::array<uint32_t, 4> GaussianRng::philox(const std::array<uint32_t, 4>& counter,
+    const std::array<uint32_t, 2>& key) {
+
+    std::array<uint32_t, 4> c = counter;
+    uint32_t k0 = key[0];
+    uint32_t k1 = key[1];
+
+    for (int round = 0; round < philoxRounds; round++) {
+        const uint64_t p0 = uint64_t(philoxM0) * uint64_t(c[0]);
+        const uint64_t p1 = uint64_t(philoxM1) * uint64_t(c[2]);
+        c = {uint32_t(p1 >> 32) ^ c[1] ^ k0, uint32_t(p1), uint32_t(p0 >> 32) ^ c[3] ^ k1, uint32_t(p0)};
+        k0 += philoxW0;
+        k1 += philoxW1;
+    }
+    return c;
+}
+
+/*
+ * @brief Map 32 bit integers to (0, 1) and transform pairs of them to normal distributed values
+ */
+std::array<float, 4> GaussianRng::boxMuller(const std::array<uint32_t, 4>& bits) {
+
+    std::array<float, 4> u{};
+    for (int i = 0; i < 4; i++) {
+        // 24 bit mantissa, never 0 so the logarithm stays finite
+        u[i] = (float(bits[i] >> 8) + 0.5f) * (1.0f / 16777216.0f);
+    }
+
+    const float r0 = std::sqrt(-2.0f * std::log(u[0]));
+    const float r1 = std::sqrt(-2.0f * std::log(u[2]));
+    return {r0 * std::cos(twoPi * u[1]), r0 * std::sin(twoPi * u[1]), r1 * std::cos(twoPi * u[3]),
+        r1 * std::sin(twoPi * u[3])};
+}
+
+std::array<float, 4> GaussianRng::gaussian(uint32_t x, uint32_t y, uint32_t seed) {
+    return boxMuller(philox({x, y, 0u, 0u}, {seed, 0u}));
+}
+
+#ifdef GAUSSIAN_SSE41
+// high 32 bits of the four unsigned 32 x 32 bit products
+GAUSSIAN_TARGET_SSE41 static inline __m128i mulhi(__m128i a, __m128i b) {
+    const __m128i even = _mm_srli_epi64(_mm_mul_epu32(a, b), 32);
+    const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_blend_epi16(even, odd, 0xCC);
+}
+
+// Philox on four counters at once, c holds the four counter words of four texels (structure of arrays)
+GAUSSIAN_TARGET_SSE41 static inline void philox4(__m128i c[4], uint32_t seed) {
+    const __m128i m0 = _mm_set1_epi32(int(philoxM0));
+    const __m128i m1 = _mm_set1_epi32(int(philoxM1));
+    uint32_t k0 = seed;
+    uint32_t k1 = 0u;
+
+    for (int round = 0; round < philoxRounds; round++) {
+        const __m128i hi0 = mulhi(m0, c[0]);
+        const __m128i lo0 = _mm_mullo_epi32(m0, c[0]);
+        const __m128i hi1 = mulhi(m1, c[2]);
+        const __m128i lo1 = _mm_mullo_epi32(m1, c[2]);
+        c[0] = _mm_xor_si128(_mm_xor_si128(hi1, c[1]), _mm_set1_epi32(int(k0)));
+        c[1] = lo1;
+        c[2] = _mm_xor_si128(_mm_xor_si128(hi0, c[3]), _mm_set1_epi32(int(k1)));
+        c[3] = lo0;
+        k0 += philoxW0;
+        k1 += philoxW1;
+    }
+}
+
+/*
+ * @brief Texels [0, count) of row y, the random bits of four texels at a time, returns the texels written
+ */
+GAUSSIAN_TARGET_SSE41 int GaussianRng::gaussianRowSse41(int count, int y, uint32_t seed, float* row) {
+
+    int x = 0;
+    // Box-Muller stays scalar to match the reference
+    for (; x + 4 <= count; x += 4) {
+        __m128i c[4] = {_mm_setr_epi32(x, x + 1, x + 2, x + 3), _mm_set1_epi32(y), _mm_setzero_si128(),
+            _mm_setzero_si128()};
+        philox4(c, seed);
+
+        alignas(16) uint32_t words[4][4];
+        for (int w = 0; w < 4; w++) {
+            _mm_store_si128(reinterpret_cast<__m128i*>(words[w]), c[w]);
+        }
+        for (int lane = 0; lane < 4; lane++) {
+            const auto g = boxMuller({words[0][lane], words[1][lane], words[2][lane], words[3][lane]});
+            std::memcpy(row + size_t(x + lane) * 4, g.data(), sizeof(g));
+        }
+    }
+    return x;
+}
+#endif
+
+bool GaussianRng::sse41Supported() {
+#if defined(GAUSSIAN_SSE41) && defined(_MSC_VER) && !defined(__clang__)
+    static const bool supported = []() {
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 19)) != 0;
+    }();
+    return supported;
+#elif defined(GAUSSIAN_SSE41)
+    static const bool supported = __builtin_cpu_supports("sse4.1");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+void GaussianRng::gaussianField(int N, uint32_t seed, std::vector<float>& field, bool simd) {
+
+    field.resize(size_t(N) * size_t(N) * 4);
+    simd = simd && sse41Supported();
+
+    for (int y = 0; y < N; y++) {
+        float* row = &field[size_t(y) * size_t(N) * 4];
+        int x = 0;
+#ifdef GAUSSIAN_SSE41
+        if (simd)
+            x = gaussianRowSse41(N, y, seed, row);
+#endif
+        for (; x < N; x++) {
+            const auto g = gaussian(uint32_t(x), uint32_t(y), seed);
+            std::memcpy(row + size_t(x) * 4, g.data(), sizeof(g));
+        }
+    }
+}
+
+bool GaussianRng::knownAnswerTest() {
+
+    // kat_vectors of Random123 for philox4x32 with 10 rounds: counter, key, expected output
+    struct Vector {
+        std::array<uint32_t, 4> counter;
+        std::array<uint32_t, 2> key;
+        std::array<uint32_t, 4> expected;
+    };
+    static const Vector vectors[] = {
+        {{0u, 0u, 0u, 0u}, {0u, 0u}, {0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u}},
+        {{0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu}, {0xffffffffu, 0xffffffffu},
+            {0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu}},
+        {{0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u}, {0xa4093822u, 0x299f31d0u},
+            {0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u}},
+    };
+    for (const Vector& v : vectors) {
+        if (philox(v.counter, v.key) != v.expected)
+            return false;
+    }
+
+    // odd size, so the SIMD loop and the scalar tail both run; without SSE4.1 this checks the plain loop
+    const int N = 13;
+    const uint32_t seed = 1234u;
+    std::vector<float> field;
+    gaussianField(N, seed, field, true);
+    for (int y = 0; y < N; y++) {
+        for (int x = 0; x < N; x++) {
+            const auto g = gaussian(uint32_t(x), uint32_t(y), seed);
+            if (std::memcmp(g.data(), &field[(size_t(y) * size_t(N) + size_t(x)) * 4], sizeof(g)) != 0)
+                return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace OGL4Core2::Plugins::PCVC::OceanSurface {
+
+    /*
+     * @brief Counter-based Gaussian random numbers, CPU counterpart of the generator in PhillipsSpectrum.comp
+     *
+     * Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3") is evaluated on the counter
+     * (x, y, 0, 0) of a texel with the seed as key, the four 32 bit outputs are turned into four normal distributed
+     * values with Box-Muller. Every texel is independent, so the same seed gives the same field on every machine and
+     * in any evaluation order.
+     */
+    class GaussianRng {
+    public:
+        static std::array<uint32_t, 4> philox(const std::array<uint32_t, 4>& counter, const std::array<uint32_t, 2>& key);
+
+        // four standard normal values for texel (x, y), same as the GPU variant
+        static std::array<float, 4> gaussian(uint32_t x, uint32_t y, uint32_t seed);
+
+        // RGBA field of N x N texels, row major; with simd four texels at once if the CPU has SSE4.1
+        static void gaussianField(int N, uint32_t seed, std::vector<float>& field, bool simd = true);
+        [[nodiscard]] static bool sse41Supported();
+
+        // Philox against the known answers of Random123 and the vectorized field against gaussian()
+        static bool knownAnswerTest();
+
+    private:
+        static std::array<float, 4> boxMuller(const std::array<uint32_t, 4>& bits);
+        static int gaussianRowSse41(int count, int y, uint32_t seed, float* row);
+    };
+} // namespace OGL4Core2::Plugins::PCVC::OceanSurface
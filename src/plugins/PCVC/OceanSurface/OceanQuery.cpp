@@ -0,0 +1,157 @@
+#include "OceanQuery.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "core/util/GLStateCache.h"
+
+using namespace OGL4Core2;
+using namespace OGL4Core2::Plugins::PCVC::OceanSurface;
+
+static_assert(sizeof(OceanQuery::Result) == 8 * sizeof(float), "Result must match the std430 layout of the shader");
+
+/*
+ * @brief Create the persistently mapped input and output buffers of all slots
+ */
+OceanQuery::OceanQuery(std::size_t capacity) : slotCapacity(capacity), nextTicket(1) {
+
+    const GLbitfield writeFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const GLbitfield readFlags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const auto inputBytes = GLsizeiptr(capacity * sizeof(glm::vec2));
+    const auto outputBytes = GLsizeiptr(capacity * sizeof(Result));
+
+    for (Slot& slot : slots) {
+        slot.input = Core::BufferHandle("Queries");
+        glNamedBufferStorage(slot.input, inputBytes, nullptr, writeFlags);
+        slot.input.setBytes(size_t(inputBytes));
+        slot.inputPtr = static_cast<glm::vec2*>(glMapNamedBufferRange(slot.input, 0, inputBytes, writeFlags));
+
+        slot.output = Core::BufferHandle("Queries");
+        glNamedBufferStorage(slot.output, outputBytes, nullptr, readFlags);
+        slot.output.setBytes(size_t(outputBytes));
+        slot.outputPtr = static_cast<const Result*>(glMapNamedBufferRange(slot.output, 0, outputBytes, readFlags));
+
+        if (slot.inputPtr == nullptr || slot.outputPtr == nullptr) {
+            throw std::runtime_error("Mapping the ocean query buffers failed!");
+        }
+    }
+}
+
+OceanQuery::~OceanQuery() {
+
+    for (Slot& slot : slots) {
+        if (slot.fence != nullptr)
+            glDeleteSync(slot.fence);
+        // persistent mappings end with the buffers
+        glUnmapNamedBuffer(slot.input);
+        glUnmapNamedBuffer(slot.output);
+    }
+}
+
+OceanQuery::Ticket OceanQuery::submit(std::vector<glm::vec2> points) {
+
+    if (points.size() > slotCapacity) {
+        throw std::invalid_argument("Ocean query batch exceeds the capacity of " + std::to_string(slotCapacity));
+    }
+    const Ticket ticket = nextTicket++;
+    queued.push_back({ticket, std::move(points)});
+    return ticket;
+}
+
+/*
+ * @brief Pack the queued batches into a free slot and resolve them with one dispatch
+ */
+void OceanQuery::dispatch(const Core::ShaderProgram& program, const Surface& surface, GLuint texDispX,
+    GLuint texDispY, GLuint texDispZ, GLuint texNormalMap) {
+
+    if (queued.empty())
+        return;
+
+    // all slots in flight means the GPU is behind, the batches wait instead of stalling
+    Slot* slot = nullptr;
+    for (Slot& candidate : slots) {
+        if (candidate.fence == nullptr && candidate.batches.empty()) {
+            slot = &candidate;
+            break;
+        }
+    }
+    if (slot == nullptr)
+        return;
+
+    // whole batches in submit order, the rest stays queued for the next frame
+    std::size_t count = 0;
+    std::size_t taken = 0;
+    for (; taken < queued.size() && count + queued[taken].points.size() <= slotCapacity; taken++) {
+        const Batch& batch = queued[taken];
+        std::memcpy(slot->inputPtr + count, batch.points.data(), batch.points.size() * sizeof(glm::vec2));
+        slot->batches.emplace_back(batch.ticket, batch.points.size());
+        count += batch.points.size();
+    }
+    queued.erase(queued.begin(), queued.begin() + std::ptrdiff_t(taken));
+
+    program.use();
+    program.setUniform("count", int(count));
+    bindSurface(program, surface, texDispX, texDispY, texDispZ, texNormalMap);
+    Core::GLStateCache::bindStorageBuffer(3, slot->input);
+    Core::GLStateCache::bindStorageBuffer(4, slot->output);
+
+    const glm::ivec3 size = program.getWorkGroupSize();
+    glDispatchCompute(GLuint((count + size_t(size.x) - 1) / size_t(size.x)), 1, 1);
+
+    // make the shader writes visible to the mapping before the fence signals
+    glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+    slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void OceanQuery::bindSurface(const Core::ShaderProgram& program, const Surface& surface, GLuint texDispX,
+    GLuint texDispY, GLuint texDispZ, GLuint texNormalMap) {
+
+    program.setUniform("origin", surface.origin);
+    program.setUniform("texelSize", surface.texelSize);
+    program.setUniform("choppiness", surface.choppiness);
+    program.setUniform("waveHeight", surface.waveHeight);
+    program.setUniform("iterations", surface.iterations);
+    Core::GLStateCache::bindImageTexture(0, texDispX, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
+    Core::GLStateCache::bindImageTexture(1, texDispY, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
+    Core::GLStateCache::bindImageTexture(2, texDispZ, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
+    Core::GLStateCache::bindImageTexture(3, texNormalMap, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
+}
+
+void OceanQuery::collect() {
+
+    for (Slot& slot : slots) {
+        if (slot.fence == nullptr)
+            continue;
+        const GLenum status = glClientWaitSync(slot.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            continue;
+
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+        const Result* src = slot.outputPtr;
+        for (const auto& [ticket, count] : slot.batches) {
+            finished[ticket].assign(src, src + count);
+            src += count;
+        }
+        slot.batches.clear();
+    }
+}
+
+bool OceanQuery::results(Ticket ticket, std::vector<Result>& out) {
+
+    auto it = finished.find(ticket);
+    if (it == finished.end())
+        return false;
+    out = std::move(it->second);
+    finished.erase(it);
+    return true;
+}
+
+std::size_t OceanQuery::pendingBatches() const {
+
+    std::size_t pending = queued.size();
+    for (const Slot& slot : slots) {
+        pending += slot.batches.size();
+    }
+    return pending;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "core/shader/ShaderProgram.h"
+#include "core/util/GLHandle.h"
+
+namespace OGL4Core2::Plugins::PCVC::OceanSurface {
+
+    /*
+     * @brief Batched water height queries, resolved on the GPU and read back without stalls
+     *
+     * Consumers submit batches of world space (x, z) points. All batches of a frame are packed into one buffer and
+     * resolved by a single dispatch of OceanQuery.comp, which inverts the horizontal choppy displacement and samples
+     * the displaced surface bilinearly. The results land in a persistently mapped buffer guarded by a fence. collect()
+     * only looks at fences that are already signaled, so results arrive one or two frames after the submit and the
+     * CPU never waits for the GPU.
+     */
+    class OceanQuery {
+    public:
+        using Ticket = uint64_t;
+
+        // layout of one result in the output SSBO, std430
+        struct Result {
+            glm::vec3 position; // displaced surface point above (x, z)
+            float residual;     // horizontal distance left after the inversion
+            glm::vec3 normal;
+            float pad;
+        };
+
+        // mapping from world space to the displacement textures and the displacement scales of the surface
+        struct Surface {
+            glm::vec2 origin; // world (x, z) of texel (0, 0)
+            float texelSize;  // world units per texel
+            float choppiness;
+            float waveHeight;
+            int iterations; // fixed point iterations of the choppy inversion
+        };
+
+        // capacity is the number of points one dispatch can resolve
+        explicit OceanQuery(std::size_t capacity);
+        ~OceanQuery();
+
+        OceanQuery(const OceanQuery&) = delete;
+        OceanQuery& operator=(const OceanQuery&) = delete;
+
+        // queue a batch for the next dispatch, throws if it is larger than the capacity
+        Ticket submit(std::vector<glm::vec2> points);
+
+        // resolve the queued batches that fit into a free slot, textures are RGBA32F with the value in .r
+        void dispatch(const Core::ShaderProgram& program, const Surface& surface, GLuint texDispX, GLuint texDispY,
+            GLuint texDispZ, GLuint texNormalMap);
+
+        // set the uniforms and image units of shaders/SurfaceSample.glsl, shared with the buoyancy pass
+        static void bindSurface(const Core::ShaderProgram& program, const Surface& surface, GLuint texDispX,
+            GLuint texDispY, GLuint texDispZ, GLuint texNormalMap);
+
+        // move the results of all finished dispatches to their tickets, never blocks
+        void collect();
+
+        // results of the ticket in submit order, false if not finished yet; a ticket is only returned once
+        bool results(Ticket ticket, std::vector<Result>& out);
+
+        [[nodiscard]] std::size_t pendingBatches() const;
+        [[nodiscard]] std::size_t capacity() const {
+            return slotCapacity;
+        }
+
+    private:
+        struct Batch {
+            Ticket ticket;
+            std::vector<glm::vec2> points;
+        };
+
+        // one dispatch in flight, the buffers are persistently mapped
+        struct Slot {
+            Core::BufferHandle input;
+            Core::BufferHandle output;
+            glm::vec2* inputPtr = nullptr;
+            const Result* outputPtr = nullptr;
+            GLsync fence = nullptr;
+            std::vector<std::pair<Ticket, std::size_t>> batches; // ticket and point count, in buffer order
+        };
+
+        std::size_t slotCapacity;
+        std::array<Slot, 3> slots;
+        std::vector<Batch> queued;
+        std::map<Ticket, std::vector<Result>> finished;
+        Ticket nextTicket;
+    };
+} // namespace OGL4Core2::Plugins::PCVC::OceanSurface
@@ -1,5 +1,8 @@
 #include "OceanSurface.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -14,16 +17,121 @@
 #include <imgui_stdlib.h>
 
 #include "core/Core.h"
+#include "core/util/GLStateCache.h"
 #include "core/util/ImGuiUtil.h"
+#include "GaussianRng.h"
 
 #define M_PI 3.14159265358979323846
-#define LOCAL_WORK_GROUP_SIZE 32
+#define LOCAL_WORK_GROUP_SIZE 32 // default work group size until the tuner measured the GPU
 #define FFT_RESOLUTION 256
 #define GRID_SIZE 256
+#define PATCH_LENGTH 1000.0f
+#define SPECTRUM_CACHE_BUDGET (64 * 1024 * 1024) // bytes of GPU memory for cached initial spectra
+#define SPECTRUM_DEBOUNCE 0.15 // seconds a dragged slider has to rest before the spectrum is recomputed
+#define FRESNEL_LUT_SIZE 256
+#define QUERY_CAPACITY 16384 // points resolved per height query dispatch
+#define QUERY_WORK_GROUP_SIZE 64
+#define QUERY_ITERATIONS 4 // fixed point iterations of the choppy inversion
+#define BODY_CAPACITY 65536
+#define BODY_WORK_GROUP_SIZE 64
+#define BODY_MAX_STEP (1.0f / 30.0f) // longer frames are simulated slower instead of exploding
+#define SPRAY_CAPACITY (1 << 20) // live spray particles
+#define SPRAY_WORK_GROUP_SIZE 256
+#define SPRAY_MAX_STEP (1.0f / 30.0f) // longer steps let fast particles pass through the surface unnoticed
+#define SPRAY_EMIT_WORK_GROUP_SIZE 16
+#define WAKE_RESOLUTION 128
+#define WAKE_MAX_REGIONS 4 // keep in sync with OceanSurface::wakeCenters
+#define WAKE_SOURCE_CAPACITY 16384 // sources per frame, bodies beyond it leave no wake
+#define WAKE_WORK_GROUP_SIZE 8
+#define WAKE_INJECT_WORK_GROUP_SIZE 64
+#define WAKE_MAX_STEP (WakeSolver::maxSteps * WakeSolver::step) // the most time the solver advances in a frame
+#define RESOLUTION_MIN (FFT_RESOLUTION / 4) // lowest level of the adaptive resolution
+// the highest level is FFT_RESOLUTION: every level is written into the displacement and normal textures of that size
+#define RESOLUTION_HOLD_FRAMES 15 // frames a new level has to be wanted before it is taken
+#define RESOLUTION_FADE_FRAMES 8
+#define MAX_VIEWS 8 // size of the Views uniform array
+#define SKYBOX_FALLBACK_COLOR {128, 160, 200, 255} // RGBA8 of a face that could not be decoded
 
 using namespace OGL4Core2;
 using namespace OGL4Core2::Plugins::PCVC::OceanSurface;
 
+/*
+ * @brief Stored sea states, switching between them is a texture swap once their spectrum is cached
+ */
+struct SeaStatePreset {
+    const char* name;
+    float windSpeed;
+    float amplitude;
+    float suppression;
+    float choppiness;
+    float waveHeight;
+};
+
+static const SeaStatePreset seaStatePresets[] = {
+    {"Calm", 20.0f, 2.0f, 0.5f, 2.0f, 0.5f},
+    {"Default", 80.0f, 4.0f, 0.1f, 5.0f, 1.0f},
+    {"Rough", 90.0f, 6.0f, 0.05f, 8.0f, 2.0f},
+    {"Storm", 100.0f, 8.0f, 0.01f, 12.0f, 4.0f},
+};
+
+/*
+ * @brief Compile time constants shared by all compute shaders, followed by the variant specific defines
+ *
+ * The FFT passes of the reduced levels are compiled with their own N, the textures keep OUTPUT_N.
+ */
+static Core::ShaderPreprocessor::Defines computeDefines(glm::ivec2 workGroupSize,
+    const Core::ShaderPreprocessor::Defines& variant = {}, int resolution = FFT_RESOLUTION) {
+    Core::ShaderPreprocessor::Defines defines = {
+        {"N", std::to_string(resolution)},
+        {"LOG2_N", std::to_string(static_cast<int>(std::log2(resolution)))},
+        {"OUTPUT_N", std::to_string(FFT_RESOLUTION)},
+        {"LOCAL_SIZE_X", std::to_string(workGroupSize.x)},
+        {"LOCAL_SIZE_Y", std::to_string(workGroupSize.y)},
+    };
+    defines.insert(defines.end(), variant.begin(), variant.end());
+    return defines;
+}
+
+/*
+ * @brief Defines of the InverseFFT variants: 0-3 butterfly stages of direction * 2 + pingpong, 4-5 the final step
+ */
+static Core::ShaderPreprocessor::Defines inverseFFTDefines(int variant) {
+    if (variant < 4)
+        return {{"DIRECTION", std::to_string(variant / 2)}, {"PINGPONG", std::to_string(variant % 2)}};
+    return {{"PINGPONG", std::to_string(variant - 4)}, {"INVERSE", ""}};
+}
+
+/*
+ * @brief Dispatch enough work groups of the program to cover width x height invocations
+ */
+static void dispatchCompute(const Core::ShaderProgram& program, int width, int height) {
+    const glm::ivec3 size = program.getWorkGroupSize();
+    glDispatchCompute((width + size.x - 1) / size.x, (height + size.y - 1) / size.y, 1);
+}
+
+/*
+ * @brief Placement of the surface grid in the world
+ */
+static glm::mat4 surfaceModelMx() {
+    return glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 5.0f));
+}
+
+/*
+ * @brief Same as fresnelFull() in OceanSurface.frag, amount of reflection at the water surface
+ */
+static float fresnelFull(float thethaI, float thethaT) {
+
+    const float waterIOR = 1.334f;
+    if (thethaI < 0.00001f) {
+        const float at0 = (waterIOR - 1.0f) / (waterIOR + 1.0f);
+        return at0 * at0;
+    }
+
+    const float t1 = std::sin(thethaI - thethaT) / std::sin(thethaI + thethaT);
+    const float t2 = std::tan(thethaI - thethaT) / std::tan(thethaI + thethaT);
+    return 0.5f * (t1 * t1 + t2 * t2);
+}
+
 /**
  * @brief OceanSurface constructor
  */
@@ -35,33 +143,107 @@ OceanSurface::OceanSurface(const Core::Core& c)
       projMx(glm::mat4(1.0f)),
       windDir(glm::vec2(1.0f, 1.0f)),
       windSpeed(80.0f),
+      time(0.0f),
       phillipsConst(4.0f),
       change(true),
       initial(true),
       butterflyStages(int(log(FFT_RESOLUTION) / log(2))),
+      resolutionController(FFT_RESOLUTION, RESOLUTION_MIN, RESOLUTION_HOLD_FRAMES, RESOLUTION_FADE_FRAMES),
+      adaptiveResolution(true),
+      pixelsPerWave(4.0f),
+      fixedResolution(FFT_RESOLUTION),
+      visibleWave(0.0f),
       choppiness(5.0f),
       waveHeight(1.0f),
       suppression(0.1f),
+      seed(1234),
+      spectrumCache(SPECTRUM_CACHE_BUDGET),
+      guiItemActive(false),
+      lastSpectrumEdit(0.0),
+      foamIndex(0),
+      foamThreshold(0.5f),
+      foamDecay(1.0f),
+      foamStrength(1.0f),
+      foamTime(0.0f),
+      wake(WAKE_RESOLUTION, WAKE_MAX_REGIONS, WAKE_SOURCE_CAPACITY),
       showWireframe(false),
       lightLong(50.0f),
       lightLat(50.00f),
+      shadingMode(0),
+      loopEnabled(false),
+      loopPeriod(20.0f),
+      loopFrames(600),
+      loopCachePath("ocean_loop.bin"),
+      playBaked(false),
+      skyboxFaceFailed{},
+      skyboxFacesPending(0),
+      skyboxFaceSize(0),
+      bindless(Core::BindlessTextureTable::supported()),
+      perlinFrequency(6.0f),
+      perlinOctaves(8),
+      perlinPersistence(0.15f),
+      noiseStrength(0.5f),
+      noiseBlendStart(200.0f),
+      noiseBlendEnd(1000.0f),
+      oceanQuery(QUERY_CAPACITY),
+      probePoint(0.0f, 0.0f),
+      probeTicket(0),
+      probeResult{},
+      probeValid(false),
+      mirrorInterval(4),
+      mirrorDownsample(1),
+      bodiesEnabled(false),
+      bodyCount(10000),
+      bodySize(2.0f),
+      bodyDensity(0.5f),
+      bodyParams{9.81f, 1.0f, 1.0f, 1.0f, 0.02f},
+      lastBodyTime(0.0),
+      viewSet(MAX_VIEWS),
+      viewInstancing(ViewSet::instancingSupported()),
+      mainViewRect(0.0f, 0.0f, 1.0f, 1.0f),
+      renderScaleEnabled(true),
+      renderScaleParams{true, 1.0f, 8.0f, 0.5f, 0.5f},
+      sprayEnabled(false),
+      sprayParams{0.3f, 0.5f, 6.0f, 2.0f, 9.81f, 0.5f},
+      sprayPointSize(0.15f),
+      lastSprayTime(0.0),
+      wakeEnabled(false),
+      wakeRegions(2),
+      wakeSize(64.0f),
+      wakeParams{8.0f, 0.01f},
+      wakeCenters{},
+      wakeBoat(true),
+      wakeBoatSpeed(8.0f),
+      wakeBoatRadius(20.0f),
+      wakePoke(false),
+      lastWakeTime(0.0),
+      shaderManager(c.getShaderCache()),
+      tuner(shaderManager, c.getProfilesPath(), "OceanSurface", FFT_RESOLUTION),
       backgroundColor(glm::vec3(0.2f, 0.2f, 0.2f)) {
       // Init Camera
       camera = std::make_shared<Core::OrbitCamera>(100.0f);
       core_.registerCamera(camera);
       // Enable depth testing.
-      glEnable(GL_DEPTH_TEST);
-    //initPerlin();
+      Core::GLStateCache::depthTest(true);
+      // a stored profile provides the work group sizes, otherwise they are tuned while the ocean is running
+      initWorkGroupTuner();
+      const bool tuned = tuner.loadProfile();
+      initFFTPlans();
       initShaders();
+      if (!tuned)
+          tuner.start();
       initFFTData();
       initTexture();
       initGrid();
       initSkybox();
       
       // GUI settings
-      textures_GUI = {texH0k, texH0minusk, texHkt_dy, texHkt_dx, texHkt_dz, texDispY, texDispX, texDispZ,
-          texNormalMap, texButterfly};
-      tex_list = "H0k\0H0minusk\0Hkt_dy\0Hkt_dx\0Hkt_dz\0DisplacementY\0DisplacementX\0DisplacementZ\0NormalMap\0Butterfly\0";
+      textures_GUI = {[this]() { return texH0k; }, [this]() { return texH0minusk; },
+          [this]() { return texHkt_dy.get(); }, [this]() { return texHkt_dx.get(); },
+          [this]() { return texHkt_dz.get(); }, [this]() { return texDispY.get(); }, [this]() { return texDispX.get(); },
+          [this]() { return texDispZ.get(); }, [this]() { return texNormalMap.get(); },
+          [this]() { return texButterfly.get(); }, [this]() { return texFoam[foamIndex].get(); }};
+      tex_list = "H0k\0H0minusk\0Hkt_dy\0Hkt_dx\0Hkt_dz\0DisplacementY\0DisplacementX\0DisplacementZ\0NormalMap\0Butterfly\0Foam\0";
 }
 
 /**
@@ -70,7 +252,7 @@ OceanSurface::OceanSurface(const Core::Core& c)
 OceanSurface::~OceanSurface() {
 
     // Reset OpenGL state.
-    glDisable(GL_DEPTH_TEST);
+    Core::GLStateCache::depthTest(false);
 }
 
 /**
@@ -79,23 +261,300 @@ OceanSurface::~OceanSurface() {
 void OceanSurface::renderGUI() {
     if (ImGui::CollapsingHeader("OceanSurface", ImGuiTreeNodeFlags_DefaultOpen)) {
         camera->drawGUI();
-        if(ImGui::SliderFloat("Wind Speed", &windSpeed, 5.0f, 100.0f)) change = true;
-        if(ImGui::SliderFloat("Suppression factor", &suppression, 0.001f, 10.0f)) change = true;
+        if (shaderManager.pending() > 0) {
+            ImGui::Text("Compiling shaders: %d pending%s", int(shaderManager.pending()),
+                shaderManager.parallel() ? " (parallel)" : "");
+        }
+        for (const auto& preset : seaStatePresets) {
+            if (ImGui::Button(preset.name)) {
+                windSpeed = preset.windSpeed;
+                phillipsConst = preset.amplitude;
+                suppression = preset.suppression;
+                choppiness = preset.choppiness;
+                waveHeight = preset.waveHeight;
+                change = true;
+            }
+            ImGui::SameLine();
+        }
+        ImGui::Text("Preset");
+
+        bool spectrumEdited = false;
+        spectrumEdited |= ImGui::SliderFloat("Wind Speed", &windSpeed, 5.0f, 100.0f);
+        spectrumEdited |= ImGui::SliderFloat("Suppression factor", &suppression, 0.001f, 10.0f);
+        spectrumEdited |= ImGui::InputInt("Seed", &seed);
+        ImGui::SameLine();
+        if (ImGui::Button("New Seed")) {
+            seed = static_cast<int>(std::random_device{}());
+            change = true;
+        }
+        if (ImGui::Button("Validate Random Numbers") && shaderGaussian)
+            validateRandomNumbers();
+        if (!rngStatus.empty()) {
+            ImGui::SameLine();
+            ImGui::TextUnformatted(rngStatus.c_str());
+        }
+        bool spectrumVariantChanged = false;
+        if (spectrum.drawGUI(spectrumVariantChanged)) {
+            if (spectrumVariantChanged) {
+                initSpectrumShader();
+                // candidates measured so far ran the previous variant
+                tuner.restartPass(int(ComputePass::Spectrum));
+            }
+            spectrumEdited = true;
+        }
+        if (spectrumEdited) {
+            change = true;
+            lastSpectrumEdit = glfwGetTime();
+        }
+        ImGui::Text("Spectrum cache: %d entries, %.1f MB", int(spectrumCache.size()),
+            double(spectrumCache.usedBytes()) / (1024.0 * 1024.0));
         ImGui::SliderFloat("Choppiness", &choppiness, 1.0f, 20.0f);
         ImGui::SliderFloat("Wave Height", &waveHeight, 0.5f, 20.0f);
         ImGui::Checkbox("Wireframe", &showWireframe);
         ImGui::SliderFloat("lightLong", &lightLong, 0.0f, 360.0f);
         ImGui::SliderFloat("lightLat", &lightLat, -90.0f, 90.0f);
-        ImGui::Image((void*) (intptr_t) texPerlin, ImVec2(512, 512));
+        ImGui::Combo("Shading", &shadingMode, "Fresnel LUT\0Analytic Fresnel\0Difference x100\0");
+        if (Core::BindlessTextureTable::supported()) {
+            if (ImGui::Checkbox("Bindless Textures", &bindless)) {
+                textureTable.reset();
+                initSurfaceShaders();
+            }
+        } else {
+            ImGui::Text("Bindless textures not supported");
+        }
+        if (ImGui::TreeNode("Views")) {
+            if (ImGui::Button("Single")) {
+                mainViewRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+                extraViews.clear();
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Split Screen")) {
+                mainViewRect = glm::vec4(0.0f, 0.0f, 0.5f, 1.0f);
+                extraViews = {{glm::vec4(0.5f, 0.0f, 0.5f, 1.0f), glm::vec3(0.0f), 45.0f, 20.0f, 300.0f}};
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Picture in Picture")) {
+                mainViewRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+                extraViews = {{glm::vec4(0.7f, 0.7f, 0.28f, 0.28f), glm::vec3(0.0f), 0.0f, 60.0f, 500.0f}};
+            }
+            ImGui::DragFloat4("Main Viewport", &mainViewRect.x, 0.01f, 0.0f, 1.0f);
+            for (size_t i = 0; i < extraViews.size(); i++) {
+                ExtraView& extra = extraViews[i];
+                ImGui::PushID(int(i));
+                ImGui::Separator();
+                ImGui::DragFloat4("Viewport", &extra.rect.x, 0.01f, 0.0f, 1.0f);
+                ImGui::DragFloat3("Target", &extra.target.x, 1.0f);
+                ImGui::SliderFloat("Yaw", &extra.yaw, -180.0f, 180.0f);
+                ImGui::SliderFloat("Pitch", &extra.pitch, 1.0f, 89.0f);
+                ImGui::SliderFloat("Distance", &extra.distance, 10.0f, 2000.0f);
+                const bool remove = ImGui::Button("Remove");
+                ImGui::PopID();
+                if (remove) {
+                    extraViews.erase(extraViews.begin() + long(i));
+                    break;
+                }
+            }
+            if (extraViews.size() + 1 < MAX_VIEWS && ImGui::Button("Add View"))
+                extraViews.push_back({glm::vec4(0.0f, 0.0f, 0.3f, 0.3f), glm::vec3(0.0f), 0.0f, 30.0f, 300.0f});
+            if (ViewSet::instancingSupported()) {
+                if (ImGui::Checkbox("Instanced Views", &viewInstancing))
+                    initSurfaceShaders();
+            } else {
+                ImGui::Text("Instanced views not supported");
+            }
+            ImGui::Text("%d views in %d batches", int(viewSet.size()), int(viewSet.batches().size()));
+            ImGui::TreePop();
+        }
+        if (ImGui::TreeNode("Render Scale")) {
+            ImGui::Checkbox("Enable", &renderScaleEnabled);
+            ImGui::Checkbox("Dynamic", &renderScaleParams.dynamic);
+            if (renderScaleParams.dynamic) {
+                ImGui::SliderFloat("Budget [ms]", &renderScaleParams.budgetMs, 1.0f, 33.0f);
+                ImGui::SliderFloat("Min Scale", &renderScaleParams.minScale, 0.25f, 1.0f);
+            } else {
+                ImGui::SliderFloat("Scale", &renderScaleParams.fixedScale, 0.25f, 1.0f);
+            }
+            ImGui::SliderFloat("Sharpness", &renderScaleParams.sharpness, 0.0f, 1.0f);
+            const glm::ivec2 size = renderScale.size();
+            ImGui::Text("%dx%d (%.0f%%), scene %.2f ms", size.x, size.y, 100.0f * renderScale.scale(),
+                renderScale.gpuTimeMs());
+            ImGui::TreePop();
+        }
+        if (ImGui::TreeNode("Adaptive Resolution")) {
+            ImGui::Checkbox("Enable", &adaptiveResolution);
+            if (adaptiveResolution) {
+                ImGui::SliderFloat("Pixels per Wave", &pixelsPerWave, 1.0f, 16.0f);
+                ImGui::Text("Smallest visible wave: %.2f", visibleWave);
+            } else {
+                // power of two levels between the minimum and the full resolution
+                int level = int(std::log2(FFT_RESOLUTION / fixedResolution));
+                const int levels = int(resolutionController.levels().size());
+                if (ImGui::SliderInt("Level", &level, 0, levels - 1))
+                    fixedResolution = FFT_RESOLUTION >> level;
+            }
+            if (resolutionController.fading()) {
+                ImGui::Text("FFT %d -> %d, fade %.2f", resolutionController.previousResolution(),
+                    resolutionController.resolution(), resolutionController.fade());
+            } else {
+                ImGui::Text("FFT %d", resolutionController.resolution());
+            }
+            ImGui::TreePop();
+        }
+        if (ImGui::TreeNode("Foam")) {
+            ImGui::SliderFloat("Jacobian Threshold", &foamThreshold, 0.0f, 1.0f);
+            ImGui::SliderFloat("Decay [1/s]", &foamDecay, 0.0f, 10.0f);
+            ImGui::SliderFloat("Strength", &foamStrength, 0.0f, 2.0f);
+            ImGui::TreePop();
+        }
+        if (ImGui::TreeNode("Height Query")) {
+            ImGui::DragFloat2("Probe (x, z)", &probePoint.x, 0.5f);
+            if (probeValid) {
+                ImGui::Text("Height: %.3f, residual: %.4f", probeResult.position.y, probeResult.residual);
+                ImGui::Text("Normal: %.2f %.2f %.2f", probeResult.normal.x, probeResult.normal.y, probeResult.normal.z);
+            }
+            ImGui::Text("Pending batches: %d", int(oceanQuery.pendingBatches()));
+
+            bool mirrorEnabled = mirror != nullptr;
+            if (ImGui::Checkbox("CPU Mirror", &mirrorEnabled)) {
+                mirror.reset();
+                mirrorStatus.clear();
+                if (mirrorEnabled)
+                    mirror = std::make_unique<DisplacementMirror>(FFT_RESOLUTION);
+            }
+            if (mirror) {
+                ImGui::SliderInt("Readback Interval", &mirrorInterval, 1, 60);
+                ImGui::SliderInt("Downsample", &mirrorDownsample, 1, 8);
+                mirror->setInterval(mirrorInterval);
+                mirror->setDownsample(mirrorDownsample);
+                if (const auto field = mirror->field()) {
+                    float height = 0.0f;
+                    mirror->sampleHeight(&probePoint, 1, &height);
+                    ImGui::Text("CPU height: %.3f, %dx%d, %d frames old", height, field->resolution,
+                        field->resolution, int(mirror->frame() - field->frame));
+                }
+                if (ImGui::Button("Benchmark"))
+                    benchmarkMirror();
+                ImGui::SameLine();
+                ImGui::Text("%s", mirrorStatus.c_str());
+            }
+            ImGui::TreePop();
+        }
+        if (ImGui::TreeNode("Floating Bodies")) {
+            if (ImGui::Checkbox("Enable", &bodiesEnabled) && bodiesEnabled && !bodies)
+                spawnBodies();
+            bool respawn = false;
+            respawn |= ImGui::SliderInt("Count", &bodyCount, 0, BODY_CAPACITY);
+            respawn |= ImGui::SliderFloat("Size", &bodySize, 0.5f, 10.0f);
+            respawn |= ImGui::SliderFloat("Density", &bodyDensity, 0.05f, 0.95f);
+            if ((respawn || ImGui::Button("Respawn")) && bodiesEnabled)
+                spawnBodies();
+            ImGui::SliderFloat("Linear Drag", &bodyParams.linearDrag, 0.0f, 5.0f);
+            ImGui::SliderFloat("Angular Drag", &bodyParams.angularDrag, 0.0f, 5.0f);
+            ImGui::TreePop();
+        }
+        if (ImGui::TreeNode("Wake")) {
+            if (ImGui::Checkbox("Enable", &wakeEnabled)) {
+                wake.clear();
+                lastWakeTime = glfwGetTime();
+            }
+            ImGui::SliderInt("Regions", &wakeRegions, 1, WAKE_MAX_REGIONS);
+            ImGui::SliderFloat("Region Size", &wakeSize, 16.0f, 256.0f);
+            ImGui::SliderFloat("Wave Speed", &wakeParams.waveSpeed, 1.0f, 20.0f);
+            ImGui::SliderFloat("Damping", &wakeParams.damping, 0.0f, 0.1f);
+            ImGui::Checkbox("Moving Source", &wakeBoat);
+            ImGui::SliderFloat("Source Speed", &wakeBoatSpeed, 0.0f, 30.0f);
+            ImGui::SliderFloat("Source Circle", &wakeBoatRadius, 5.0f, 100.0f);
+            ImGui::SliderFloat("Body Wake", &bodyParams.wakeStrength, 0.0f, 0.2f);
+            for (int r = 2; r < wakeRegions; r++) {
+                ImGui::DragFloat2(("Region " + std::to_string(r)).c_str(), &wakeCenters[r].x, 0.5f);
+            }
+            if (ImGui::Button("Splash at Probe"))
+                wakePoke = true;
+            ImGui::TreePop();
+        }
+        if (ImGui::TreeNode("Spray")) {
+            if (ImGui::Checkbox("Enable", &sprayEnabled)) {
+                // the particle buffers take 64 MB, they only exist while the spray is on
+                spray.reset();
+                if (sprayEnabled) {
+                    spray = std::make_unique<SpraySystem>(SPRAY_CAPACITY);
+                    lastSprayTime = glfwGetTime();
+                }
+            }
+            ImGui::SliderFloat("Jacobian Threshold", &sprayParams.emitThreshold, 0.0f, 1.0f);
+            ImGui::SliderFloat("Emission", &sprayParams.emitProbability, 0.0f, 1.0f);
+            ImGui::SliderFloat("Speed", &sprayParams.emitSpeed, 0.0f, 20.0f);
+            ImGui::SliderFloat("Lifetime [s]", &sprayParams.lifetime, 0.1f, 10.0f);
+            ImGui::SliderFloat("Drag", &sprayParams.drag, 0.0f, 5.0f);
+            ImGui::SliderFloat("Point Size", &sprayPointSize, 0.01f, 1.0f);
+            if (spray && ImGui::Button("Clear"))
+                spray->clear();
+            ImGui::TreePop();
+        }
+        if (ImGui::TreeNode("Periodic Ocean")) {
+            ImGui::Checkbox("Loop", &loopEnabled);
+            ImGui::SliderFloat("Period [s]", &loopPeriod, 1.0f, 120.0f);
+            ImGui::InputInt("Frames", &loopFrames);
+            loopFrames = std::max(loopFrames, 1);
+            ImGui::InputText("Cache File", &loopCachePath);
+            if (ImGui::Button("Bake")) {
+                bakeLoop();
+            }
+            ImGui::SameLine();
+            if (ImGui::Checkbox("Play Baked", &playBaked)) {
+                loopCache.reset();
+                if (playBaked) {
+                    try {
+                        loopCache = std::make_unique<DisplacementCache>(loopCachePath);
+                        if (loopCache->resolution() != FFT_RESOLUTION) {
+                            throw std::runtime_error("Cache resolution does not match the FFT resolution!");
+                        }
+                        // the surface shader colors by the height range of the loop
+                        float heightRange[2] = {loopCache->heightMax(), loopCache->heightMin()};
+                        glNamedBufferSubData(ssboHeightRange, 0, sizeof(heightRange), heightRange);
+                        loopStatus = "Playing " + std::to_string(loopCache->frameCount()) + " frames";
+                    } catch (const std::exception& e) {
+                        loopCache.reset();
+                        playBaked = false;
+                        loopStatus = e.what();
+                    }
+                }
+            }
+            if (!loopStatus.empty())
+                ImGui::TextUnformatted(loopStatus.c_str());
+            ImGui::TreePop();
+        }
+        if (ImGui::TreeNode("Distant Noise")) {
+            bool noiseEdited = false;
+            noiseEdited |= ImGui::SliderFloat("Frequency", &perlinFrequency, 1.0f, 16.0f, "%.0f");
+            noiseEdited |= ImGui::SliderInt("Octaves", &perlinOctaves, 1, 8);
+            noiseEdited |= ImGui::SliderFloat("Persistence", &perlinPersistence, 0.0f, 1.0f);
+            if (noiseEdited) {
+                perlinFrequency = std::round(perlinFrequency); // whole lattice cells keep the noise tileable
+                if (shaderPerlinNoise)
+                    renderPerlinNoise(*shaderPerlinNoise);
+            }
+            ImGui::SliderFloat("Strength", &noiseStrength, 0.0f, 1.0f);
+            ImGui::SliderFloat("Blend Start", &noiseBlendStart, 0.0f, 2000.0f);
+            ImGui::SliderFloat("Blend End", &noiseBlendEnd, 0.0f, 4000.0f);
+            if (ImGui::Button("Validate on CPU")) {
+                if (shaderPerlinNoise)
+                    validatePerlinNoise();
+            }
+            if (!perlinStatus.empty())
+                ImGui::TextUnformatted(perlinStatus.c_str());
+            ImGui::Image((void*) (intptr_t) texPerlin.get(), ImVec2(512, 512));
+            ImGui::TreePop();
+        }
+        tuner.drawGUI();
         ImGui::Combo("Show Textures", &currGUItex, tex_list);
-        if (textures_GUI[currGUItex] == texButterfly)
-            ImGui::Image((void*) (intptr_t) textures_GUI[currGUItex], ImVec2(30 * 512, 512));
+        if (textures_GUI[currGUItex]() == texButterfly)
+            ImGui::Image((void*) (intptr_t) textures_GUI[currGUItex](), ImVec2(30 * 512, 512));
         else
-            ImGui::Image((void*) (intptr_t) textures_GUI[currGUItex], ImVec2(512, 512));
+            ImGui::Image((void*) (intptr_t) textures_GUI[currGUItex](), ImVec2(512, 512));
 
-       
-       
     }
+    guiItemActive = ImGui::IsAnyItemActive();
 }
 
 
@@ -108,264 +567,788 @@ void OceanSurface::render() {
     glClearColor(backgroundColor.x, backgroundColor.y, backgroundColor.z, 1.0f); 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // compute the initial time-independent spectrum when change occurs
-    if (change)
-        renderInitialSpectrum();
-    
-    // compute butterfly factors for FFT operation, runs only once to create data
-    if (initial) {
-        renderButterfly();
-        renderPerlinNoise();
-    }
-    // time-dependent wave amplitude
-    renderWaveAmplitude();
+    shaderManager.poll();
+    updateSpectrumProgram();
+    uploadSkyboxFaces();
+    updateTextureTable();
+    oceanQuery.collect();
+    updateProbe();
 
-    // IFFT computation
-    renderIFFT(texHkt_dy, texDispY); // Height Field texture
-    renderIFFT(texHkt_dx, texDispX);
-    renderIFFT(texHkt_dz, texDispZ);
-    renderIFFT(texSlope_x, texNormalX); // Normal Map texture
-    renderIFFT(texSlope_z, texNormalZ);
+    simulate(float(glfwGetTime()));
 
-    // normal map computation
-    renderNormalMap();
-   
     renderGUI();
-    
-    // render ocean surface
-    glPolygonMode(GL_FRONT_AND_BACK, showWireframe ? GL_LINE : GL_FILL);
-    projMx = glm::perspective(glm::radians(45.0f), (float) (windowWidth / windowHeight), 0.1f, 10000.0f);
 
-    shaderOceanSurface->use();
+    // the scene goes into the scaled target, the window gets the upscaled result before ImGui draws on top
+    const bool scaled = renderScaleEnabled && shaderUpscale;
+    if (scaled)
+        renderScale.begin(renderScaleParams);
+
+    // every view draws the state simulated above
+    const std::vector<ViewSet::View> views = collectViews();
+    projMx = views.front().projMx;
+    viewSet.upload(views);
+    for (const ViewSet::Batch& batch : viewSet.batches())
+        draw(batch);
+
+    if (scaled) {
+        renderScale.end();
+        renderScale.present(*shaderUpscale, renderScaleParams);
+    } else {
+        glViewport(0, 0, windowWidth, windowHeight);
+    }
+}
+
+/*
+ * @brief Advance everything that does not depend on a view to the given time, once per frame
+ */
+void OceanSurface::simulate(float simulationTime) {
+
+    time = simulationTime;
+
+    if (playBaked && loopCache) {
+        // baked playback replaces the whole FFT pipeline by a single upload
+        loopCache->upload(time, texDispY, texDispX, texDispZ, texNormalMap);
+    } else if (simulationReady()) {
+        // keep the phase argument small, the periodic spectrum repeats after each period anyway
+        if (loopEnabled)
+            time = std::fmod(time, loopPeriod);
+
+        // compute the initial time-independent spectrum when change occurs, held back while a slider is dragged
+        // and while the program of a new spectrum variant still compiles
+        const bool variantReady = spectrumVariant == Core::ShaderPreprocessor::defineString(spectrum.shaderDefines());
+        if (change && variantReady && (!guiItemActive || glfwGetTime() - lastSpectrumEdit > SPECTRUM_DEBOUNCE))
+            updateInitialSpectrum();
+
+        // compute butterfly factors for FFT operation, runs only once to create data
+        if (initial) {
+            renderButterfly(*shaderButterfly);
+            renderPerlinNoise(*shaderPerlinNoise);
+        }
 
-    // texture setting
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, texDispY);
-    shaderOceanSurface->setUniform("dispY", 1);
+        // benchmark one work group size per frame, the simulation below recomputes everything the tuner wrote
+        if (tuner.running() && !change && tuner.step())
+            initComputeShaders(); // the current programs stay in use until the tuned ones linked
 
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, texDispX);
-    shaderOceanSurface->setUniform("dispX", 2);
-    
-    glActiveTexture(GL_TEXTURE3);
-    glBindTexture(GL_TEXTURE_2D, texDispZ);
-    shaderOceanSurface->setUniform("dispZ", 3);
+        updateResolution();
+        renderSimulation();
+    }
+
+    // resolve the height queries of this frame against the current displacement
+    if (shaderQuery && ((playBaked && loopCache) || simulationReady()))
+        oceanQuery.dispatch(*shaderQuery, querySurface(), texDispX, texDispY, texDispZ, texNormalMap);
+    if (mirror && ((playBaked && loopCache) || simulationReady()))
+        mirror->update(texDispX, texDispY, texDispZ, querySurface());
+    // the CPU sources go first, the bodies append theirs on the GPU
+    wake.setRegionCount(wakeEnabled ? wakeRegions : 0);
+    if (wakeEnabled)
+        updateWakeSources();
+    if (bodiesEnabled && bodies && shaderBuoyancy && ((playBaked && loopCache) || simulationReady()))
+        simulateBodies();
+    if (wakeEnabled && shaderWakeInject && shaderWakeStep)
+        updateWake();
+    // the spray needs the Jacobian of the normal pass, the baked loop does not store it
+    if (spray && shaderSprayEmit && shaderSpraySimulate && shaderSprayFinalize && !playBaked && simulationReady())
+        updateSpray();
+}
+
+/*
+ * @brief Draw the simulated state into the views of a batch, the views of a batch do not overlap
+ */
+void OceanSurface::draw(const ViewSet::Batch& batch) {
+
+    viewSet.clear(batch);
+
+    // every pass runs only once its program is compiled, the skybox is usually the first one
+    // the bindless programs have to wait for the texture table, it needs the complete skybox
+    const bool texturesReady = !bindless || textureTable;
+    if (shaderOceanSurface && texturesReady && ((playBaked && loopCache) || simulationReady()))
+        renderOceanSurface(batch);
+
+    for (int view = batch.first; view < batch.first + batch.count; view++) {
+        viewSet.setViewport(view);
+        if (bodiesEnabled && bodies && shaderBody)
+            renderBodies(view);
+
+        // render cubemap texture once all faces are loaded
+        if (shaderSkybox && texturesReady && skyboxFacesPending == 0)
+            renderSkybox(view);
+
+        // translucent, after everything opaque
+        if (spray && shaderSpray)
+            renderSpray(view);
+    }
+}
+
+/*
+ * @brief Cameras and pixel viewports of all views in the render target, the main camera first
+ */
+std::vector<ViewSet::View> OceanSurface::collectViews() const {
+
+    const glm::vec2 size = glm::vec2(renderSize());
+    const auto viewport = [size](const glm::vec4& rect) {
+        return glm::vec4(std::floor(rect.x * size.x), std::floor(rect.y * size.y),
+            std::max(std::floor(rect.z * size.x), 1.0f), std::max(std::floor(rect.w * size.y), 1.0f));
+    };
+    const auto projection = [](const glm::vec4& rect) {
+        return glm::perspective(glm::radians(45.0f), rect.z / rect.w, 0.1f, 10000.0f);
+    };
+
+    std::vector<ViewSet::View> views;
+    const glm::vec4 main = viewport(mainViewRect);
+    views.push_back(ViewSet::makeView(camera->viewMx(), projection(main), main));
+    for (const ExtraView& extra : extraViews) {
+        const float yaw = glm::radians(extra.yaw);
+        const float pitch = glm::radians(extra.pitch);
+        const glm::vec3 eye = extra.target + extra.distance * glm::vec3(std::cos(pitch) * std::sin(yaw),
+                                                                  std::sin(pitch), std::cos(pitch) * std::cos(yaw));
+        const glm::vec4 rect = viewport(extra.rect);
+        views.push_back(
+            ViewSet::makeView(glm::lookAt(eye, extra.target, glm::vec3(0.0f, 1.0f, 0.0f)), projection(rect), rect));
+    }
+    return views;
+}
+
+/*
+ * @brief Size of the target the views are rasterized into, in pixels
+ */
+glm::ivec2 OceanSurface::renderSize() const {
+    return renderScaleEnabled && shaderUpscale ? renderScale.size() : glm::ivec2(int(windowWidth), int(windowHeight));
+}
 
-    glActiveTexture(GL_TEXTURE4);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, texSkybox);
-    shaderOceanSurface->setUniform("skybox", 4);
+/*
+ * @brief Draw the displaced surface grid into the views of the batch, instanced if the shader selects the viewport
+ */
+void OceanSurface::renderOceanSurface(const ViewSet::Batch& batch) {
 
-    glActiveTexture(GL_TEXTURE5);
-    glBindTexture(GL_TEXTURE_2D, texNormalMap);
-    shaderOceanSurface->setUniform("normalMap", 5);
+    Core::GLStateCache::polygonMode(showWireframe ? GL_LINE : GL_FILL);
 
-    shaderOceanSurface->setUniform("projMx", projMx);
-    shaderOceanSurface->setUniform("modelMx", glm::translate(glm::mat4(1.0f), glm::vec3(0.0f,0.0f,5.0f)));
-    shaderOceanSurface->setUniform("viewMx", camera->viewMx());
+    shaderOceanSurface->use();
+
+    if (textureTable) {
+        // the shaders read the resident handles from the table
+        Core::GLStateCache::bindStorageBuffer(2, textureTable->buffer());
+    } else {
+        // texture setting, the sampler objects hold the filtering of each unit
+        const GLuint textures[8] = {texDispY, texDispX, texDispZ, texSkybox, texNormalMap, texPerlin, texFresnelLUT,
+            texFoam[foamIndex]};
+        const GLuint samplers[8] = {samplerNearest, samplerNearest, samplerNearest, samplerSkybox, samplerNearest,
+            samplerNearest, samplerLinear, samplerLinear};
+        Core::GLStateCache::bindTextures(1, 8, textures);
+        Core::GLStateCache::bindSamplers(1, 8, samplers);
+        shaderOceanSurface->setUniform("dispY", 1);
+        shaderOceanSurface->setUniform("dispX", 2);
+        shaderOceanSurface->setUniform("dispZ", 3);
+        shaderOceanSurface->setUniform("skybox", 4);
+        shaderOceanSurface->setUniform("normalMap", 5);
+        shaderOceanSurface->setUniform("perlinNoise", 6);
+        shaderOceanSurface->setUniform("fresnelLUT", 7);
+        shaderOceanSurface->setUniform("foam", 8);
+        Core::GLStateCache::bindTextureUnit(9, wake.texture());
+        Core::GLStateCache::bindSampler(9, samplerLinear);
+        shaderOceanSurface->setUniform("wake", 9);
+    }
+    shaderOceanSurface->setUniform("foamIndex", foamIndex);
+    wake.setUniforms(*shaderOceanSurface);
+    // the baked loop does not store the foam and skips the normal pass
+    shaderOceanSurface->setUniform("foamStrength", playBaked && loopCache ? 0.0f : foamStrength);
+    shaderOceanSurface->setUniform("noiseStrength", noiseStrength);
+    shaderOceanSurface->setUniform("noiseBlendStart", noiseBlendStart);
+    shaderOceanSurface->setUniform("noiseBlendEnd", noiseBlendEnd);
+
+    shaderOceanSurface->setUniform("shadingMode", shadingMode);
+
+    shaderOceanSurface->setUniform("modelMx", surfaceModelMx());
     shaderOceanSurface->setUniform("choppiness", choppiness);
     shaderOceanSurface->setUniform("waveHeight", waveHeight);
-    shaderOceanSurface->setUniform("camPos", glm::vec3(glm::inverse(camera->viewMx())[3]));
-    shaderOceanSurface->setUniform("invViewMx", glm::inverse(camera->viewMx()));
-    glm::vec3 lightDir = glm::vec3(cosf(glm::radians(lightLat)) * cosf(glm::radians(lightLong)),
+    shaderOceanSurface->setUniform("lightDir", lightDirection());
+
+    if (viewInstancing) {
+        viewSet.setViewports(batch);
+        shaderOceanSurface->setUniform("viewIndex", batch.first);
+        vaOceanSurface->draw(batch.count);
+    } else {
+        for (int view = batch.first; view < batch.first + batch.count; view++) {
+            viewSet.setViewport(view);
+            shaderOceanSurface->setUniform("viewIndex", view);
+            vaOceanSurface->draw();
+        }
+    }
+}
+
+/*
+ * @brief Direction towards the light from the GUI angles
+ */
+glm::vec3 OceanSurface::lightDirection() const {
+    return glm::vec3(cosf(glm::radians(lightLat)) * cosf(glm::radians(lightLong)),
         cosf(glm::radians(lightLat)) * sinf(glm::radians(lightLong)), sinf(glm::radians(lightLat)));
-    shaderOceanSurface->setUniform("lightDir", lightDir);
-    vaOceanSurface->draw();
+}
+
+/*
+ * @brief One buoyancy step with the time since the last frame, the matrices are drawn in the same frame
+ */
+void OceanSurface::simulateBodies() {
+
+    const double now = glfwGetTime();
+    const float dt = std::min(float(now - lastBodyTime), BODY_MAX_STEP);
+    lastBodyTime = now;
 
-    // render cubemap texture
-    renderSkybox();
+    bodies->simulate(*shaderBuoyancy, querySurface(), glm::vec2(float(GRID_SIZE)), bodyParams, dt, texDispX,
+        texDispY, texDispZ, texNormalMap, wakeEnabled ? wake.sourceBuffer() : 0, wake.sourceCapacity());
 }
 
-void OceanSurface::renderPerlinNoise() {
+/*
+ * @brief Move the wake regions to their targets and upload the sources of the CPU
+ */
+void OceanSurface::updateWakeSources() {
+
+    const float t = float(glfwGetTime());
+    const glm::vec2 boat = wakeBoatRadius * glm::vec2(std::cos(t * wakeBoatSpeed / wakeBoatRadius),
+                                                std::sin(t * wakeBoatSpeed / wakeBoatRadius));
+    const glm::vec3 eye = glm::vec3(glm::inverse(camera->viewMx())[3]);
+    wakeCenters[0] = glm::vec2(eye.x, eye.z);
+    wakeCenters[1] = boat;
+    for (int r = 0; r < wakeRegions; r++) {
+        wake.setRegion(r, wakeCenters[r], wakeSize);
+    }
 
-    shaderPerlinNoise->use();
-    glBindImageTexture(0, texPerlin, 0, GL_FALSE, 0, GL_READ_WRITE,GL_RGBA32F);
-    shaderPerlinNoise->setUniform("N", FFT_RESOLUTION);
-    float frequency = 1.0f;
-    float persistence = 0.15; // 0~1
-    float amplitude = 1.0f;
-   
-    for (int i = 0; i < 8; i++) { // loop through octaves
-        shaderPerlinNoise->setUniform("frequency", frequency);
-        shaderPerlinNoise->setUniform("amplitude", amplitude);
+    // the heights are injected once per frame, so they scale with the frame time
+    const float dt = std::min(float(glfwGetTime() - lastWakeTime), WAKE_MAX_STEP);
+    std::vector<WakeSolver::Source> sources;
+    if (wakeBoat)
+        sources.push_back({boat, 2.0f, -0.5f * wakeBoatSpeed * dt});
+    if (wakePoke) {
+        sources.push_back({probePoint, 3.0f, -1.0f});
+        wakePoke = false;
+    }
+    wake.beginFrame(sources);
+}
+
+/*
+ * @brief Splat the sources and advance the wake regions with their fixed step
+ */
+void OceanSurface::updateWake() {
+
+    const double now = glfwGetTime();
+    const float dt = float(now - lastWakeTime);
+    lastWakeTime = now;
+    wake.update(*shaderWakeInject, *shaderWakeStep, wakeParams, dt);
+}
+
+/*
+ * @brief Draw all floating bodies into a view with one instanced draw call
+ */
+void OceanSurface::renderBodies(int view) {
+
+    Core::GLStateCache::polygonMode(showWireframe ? GL_LINE : GL_FILL);
+    shaderBody->use();
+    shaderBody->setUniform("viewIndex", view);
+    shaderBody->setUniform("lightDir", lightDirection());
+    bodies->draw(*shaderBody);
+}
+
+/*
+ * @brief Simulate and emit the spray with the time since the last frame, all on the GPU
+ */
+void OceanSurface::updateSpray() {
+
+    const double now = glfwGetTime();
+    const float dt = std::min(float(now - lastSprayTime), SPRAY_MAX_STEP);
+    lastSprayTime = now;
+
+    // a single inversion step is accurate enough to let spray end on the surface
+    OceanQuery::Surface surface = querySurface();
+    surface.iterations = 1;
+    sprayParams.gravity = bodyParams.gravity;
+    spray->update({*shaderSprayEmit, *shaderSpraySimulate, *shaderSprayFinalize}, surface, FFT_RESOLUTION,
+        sprayParams, dt, texDispX, texDispY, texDispZ, texNormalMap);
+}
+
+/*
+ * @brief Draw the spray, the particle count comes from the indirect buffer
+ */
+void OceanSurface::renderSpray(int view) {
+
+    shaderSpray->use();
+    shaderSpray->setUniform("viewIndex", view);
+    shaderSpray->setUniform("pointSize", sprayPointSize);
+    spray->draw(*shaderSpray);
+}
+
+/*
+ * @brief Replace the bodies by a new random set over the surface patch
+ */
+void OceanSurface::spawnBodies() {
+
+    if (!bodies)
+        bodies = std::make_unique<BuoyancySystem>(BODY_CAPACITY);
+
+    const OceanQuery::Surface surface = querySurface();
+    bodies->spawn(size_t(bodyCount), surface.origin, surface.origin + glm::vec2(float(GRID_SIZE)), bodySize,
+        bodyDensity);
+    lastBodyTime = glfwGetTime();
+}
+
+/*
+ * @brief All compute passes of the simulation have their programs
+ */
+bool OceanSurface::simulationReady() const {
+    const auto ready = [](const auto& programs) {
+        return std::all_of(programs.begin(), programs.end(), [](const auto& p) { return p != nullptr; });
+    };
+    return spectrumProgram() && shaderAmplitude && shaderButterfly && !shaderInverseFFT.empty() &&
+           ready(shaderInverseFFT) && shaderNormalMap && shaderPerlinNoise;
+}
+
+/*
+ * @brief Spectrum program in use, null until the first variant linked
+ */
+Core::ShaderProgram* OceanSurface::spectrumProgram() const {
+    auto it = shaderPSpectrum.find(spectrumKey);
+    return it != shaderPSpectrum.end() ? it->second.get() : nullptr;
+}
+
+/*
+ * @brief Switch to the requested spectrum variant once it linked, until then the last one stays in use
+ */
+void OceanSurface::updateSpectrumProgram() {
+
+    const std::string key = Core::ShaderPreprocessor::defineString(spectrumDefines());
+    if (key == spectrumKey)
+        return;
+    auto it = shaderPSpectrum.find(key);
+    if (it == shaderPSpectrum.end() || !it->second)
+        return;
+    spectrumKey = key;
+    spectrumVariant = Core::ShaderPreprocessor::defineString(spectrum.shaderDefines());
+}
+
+/*
+ * @brief Defines of the spectrum variant for the current spectrum settings and work group size
+ */
+Core::ShaderPreprocessor::Defines OceanSurface::spectrumDefines() const {
+    return computeDefines(workGroupSize(ComputePass::Spectrum), spectrum.shaderDefines());
+}
+
+/*
+ * @brief Time-dependent part of the simulation: amplitudes, IFFTs and normal map for the current time
+ *
+ * With adaptive set the level of the resolution controller is simulated, while two levels cross-fade the old one
+ * is written first and the new one is mixed into it. The full resolution stands in for a level still compiling.
+ */
+void OceanSurface::renderSimulation(bool adaptive) {
+
+    const bool fading = adaptive && resolutionController.fading() &&
+                        renderSpectrumLevel(resolutionController.previousResolution(), 1.0f);
+    const int resolution = adaptive ? resolutionController.resolution() : FFT_RESOLUTION;
+    if (!renderSpectrumLevel(resolution, fading ? resolutionController.fade() : 1.0f))
+        renderSpectrumLevel(FFT_RESOLUTION, 1.0f);
+
+    // normal map computation
+    renderNormalMap(*shaderNormalMap);
+}
+
+/*
+ * @brief Amplitudes and IFFTs of one resolution level into the full resolution displacement textures
+ *
+ * Returns false while the programs of the level are compiling. The butterfly data of a reduced level is computed
+ * on its first use.
+ */
+bool OceanSurface::renderSpectrumLevel(int resolution, float blend) {
+
+    const Core::ShaderProgram* amplitude = shaderAmplitude.get();
+    const WorkGroupTuner::Programs* inverseFFT = &shaderInverseFFT;
+    GLuint butterfly = texButterfly;
+
+    if (resolution != FFT_RESOLUTION) {
+        auto it = fftPlans.find(resolution);
+        if (it == fftPlans.end())
+            return false;
+        FFTPlan& plan = it->second;
+        const bool ready = plan.amplitude && plan.butterfly && !plan.inverseFFT.empty() &&
+                           std::all_of(plan.inverseFFT.begin(), plan.inverseFFT.end(),
+                               [](const auto& p) { return p != nullptr; });
+        if (!ready)
+            return false;
+
+        if (!plan.butterflyReady) {
+            // the butterfly pass reads the bit reversed indices of the level from binding 0
+            plan.butterfly->use();
+            Core::GLStateCache::bindStorageBuffer(0, plan.ssboBitReversed);
+            Core::GLStateCache::bindImageTexture(0, plan.texButterfly, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+            dispatchCompute(*plan.butterfly, int(std::log2(resolution)), resolution);
+            glMemoryBarrier(GL_ALL_BARRIER_BITS);
+            Core::GLStateCache::bindStorageBuffer(0, ssboBitReversed);
+            plan.butterflyReady = true;
+        }
+        amplitude = plan.amplitude.get();
+        inverseFFT = &plan.inverseFFT;
+        butterfly = plan.texButterfly;
+    }
+
+    // time-dependent wave amplitude
+    renderWaveAmplitude(*amplitude, resolution);
+
+    // IFFT computation
+    renderIFFT(texHkt_dy, texDispY, *inverseFFT, butterfly, resolution, blend); // Height Field texture
+    renderIFFT(texHkt_dx, texDispX, *inverseFFT, butterfly, resolution, blend);
+    renderIFFT(texHkt_dz, texDispZ, *inverseFFT, butterfly, resolution, blend);
+    renderIFFT(texSlope_x, texNormalX, *inverseFFT, butterfly, resolution, blend); // Normal Map texture
+    renderIFFT(texSlope_z, texNormalZ, *inverseFFT, butterfly, resolution, blend);
+    return true;
+}
+
+/*
+ * @brief Feed the resolution controller with the smallest wave visible from the camera
+ *
+ * The camera height over the water is the distance to the closest visible surface.
+ */
+void OceanSurface::updateResolution() {
+
+    if (adaptiveResolution) {
+        const glm::vec3 eye = glm::vec3(glm::inverse(camera->viewMx())[3]);
+        visibleWave = ResolutionController::visibleWavelength(std::max(std::abs(eye.y), 1.0f), projMx[1][1],
+            float(renderSize().y) * mainViewRect.w, pixelsPerWave);
+    } else {
+        // the shortest wave of the fixed level, so it is faded in like any other switch
+        visibleWave = 2.0f * float(GRID_SIZE) / float(fixedResolution);
+    }
+    resolutionController.update(visibleWave, float(GRID_SIZE));
+}
+
+/*
+ * @brief Simulate one loop period frame by frame and store the result in the cache file
+ */
+void OceanSurface::bakeLoop() {
+
+    // the loop has to show the selected spectrum, not the variant still in use while it compiles
+    if (!simulationReady() || spectrumVariant != Core::ShaderPreprocessor::defineString(spectrum.shaderDefines())) {
+        loopStatus = "Shaders are still compiling!";
+        return;
+    }
+
+    // a baked loop is only seamless with the quantized dispersion relation
+    loopEnabled = true;
+    playBaked = false;
+    loopCache.reset();
+
+    if (change)
+        updateInitialSpectrum();
+    if (initial) {
+        renderButterfly(*shaderButterfly);
+        renderPerlinNoise(*shaderPerlinNoise);
+    }
+
+    // restart the height range, the cache stores the range of this loop
+    float heightRange[2] = {0.0f, 0.0f};
+    glNamedBufferSubData(ssboHeightRange, 0, sizeof(heightRange), heightRange);
+
+    try {
+        DisplacementCacheWriter writer(loopCachePath, FFT_RESOLUTION, loopFrames, loopPeriod);
+        for (int i = 0; i < loopFrames; i++) {
+            time = loopPeriod * float(i) / float(loopFrames);
+            renderSimulation(false);
+            writer.writeFrame(texDispY, texDispX, texDispZ, texNormalMap);
+        }
 
-        glDispatchCompute(FFT_RESOLUTION / LOCAL_WORK_GROUP_SIZE, FFT_RESOLUTION / LOCAL_WORK_GROUP_SIZE, 1);
-        glMemoryBarrier(GL_ALL_BARRIER_BITS);
+        glGetNamedBufferSubData(ssboHeightRange, 0, sizeof(heightRange), heightRange);
+        writer.finish(heightRange[0], heightRange[1]);
 
-        frequency *= 2.0f;
-        amplitude *= persistence;
+        loopStatus = "Baked " + std::to_string(loopFrames) + " frames to " + loopCachePath;
+    } catch (const std::exception& e) {
+        loopStatus = e.what();
     }
+}
+
+/*
+ * @brief Tileable multi-octave Perlin noise, all octaves in a single dispatch
+ */
+void OceanSurface::renderPerlinNoise(const Core::ShaderProgram& program) {
+
+    program.use();
+    Core::GLStateCache::bindImageTexture(0, texPerlin, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    program.setUniform("frequency", perlinFrequency);
+    program.setUniform("persistence", perlinPersistence);
+    program.setUniform("octaves", perlinOctaves);
 
+    dispatchCompute(program, FFT_RESOLUTION, FFT_RESOLUTION);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+}
+
+/*
+ * @brief Compare the GPU noise texture with the CPU generator, the SSE2 and the plain path where both exist
+ */
+void OceanSurface::validatePerlinNoise() {
+
+    std::vector<float> gpu(size_t(FFT_RESOLUTION) * size_t(FFT_RESOLUTION));
+    glGetTextureImage(texPerlin, 0, GL_RED, GL_FLOAT, GLsizei(gpu.size() * sizeof(float)), gpu.data());
+
+    const auto maxError = [this, &gpu](bool simd) {
+        std::vector<float> cpu;
+        PerlinNoise::generate(FFT_RESOLUTION, perlinFrequency, perlinOctaves, perlinPersistence, cpu, simd);
+        float error = 0.0f;
+        for (size_t i = 0; i < cpu.size(); i++) {
+            error = std::max(error, std::abs(cpu[i] - gpu[i]));
+        }
+        return error;
+    };
+
+    std::ostringstream status;
+    status << "CPU/GPU max difference: " << std::scientific << std::setprecision(2);
+    if (PerlinNoise::simdSupported())
+        status << "SSE2 " << maxError(true) << ", ";
+    status << "scalar " << maxError(false);
+    perlinStatus = status.str();
 }
 
 /*
  * @brief Render skybox for background
  */
-void OceanSurface::renderSkybox() { // render it as last in render()
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+void OceanSurface::renderSkybox(int view) { // render it as last in draw()
+    Core::GLStateCache::polygonMode(GL_FILL);
     // since the cubemap will always have a depth of 1.0, we need the equal sign so it doesn#t get discarded
-    glDepthFunc(GL_LEQUAL);
+    Core::GLStateCache::depthFunc(GL_LEQUAL);
     shaderSkybox->use();
 
-    glActiveTexture(GL_TEXTURE6);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, texSkybox);
-    shaderSkybox->setUniform("skybox", 6);
+    if (textureTable) {
+        Core::GLStateCache::bindStorageBuffer(2, textureTable->buffer());
+    } else {
+        Core::GLStateCache::bindTextureUnit(6, texSkybox);
+        Core::GLStateCache::bindSampler(6, samplerSkybox);
+        shaderSkybox->setUniform("skybox", 6);
+    }
 
-    shaderSkybox->setUniform("projMx", projMx);
     shaderSkybox->setUniform("modelMx", glm::mat4(1.0f));
-    // remove the translation of view matrix to keep skybox surrounded by the camera, i.e, worldpos is set at camera,
-    // always keep camera at the center
-    shaderSkybox->setUniform("viewMx", glm::mat4(glm::mat3(camera->viewMx())));
+    // the vertex shader removes the translation of the view, so the skybox stays centered at the camera
+    shaderSkybox->setUniform("viewIndex", view);
 
     vaSkybox->draw();
-    glDepthFunc(GL_LESS); // set depth back to default
-    glUseProgram(0);
+    Core::GLStateCache::depthFunc(GL_LESS); // set depth back to default
 }
 
 /*
- * @brief Compute Normalmap
+ * @brief Compare the Gaussian random numbers of the spectrum pass with GaussianRng for the current seed
+ *
+ * The time-dependent amplitude textures are used as scratch, the next simulation step rewrites them.
  */
-void OceanSurface::renderNormalMap() {
+void OceanSurface::validateRandomNumbers() {
 
-    shaderNormalMap->use();
-    glBindImageTexture(0, texDispY, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
-    glBindImageTexture(1, texNormalX, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
-    glBindImageTexture(2, texNormalZ, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
-    glBindImageTexture(3, texNormalMap, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
-    shaderNormalMap->setUniform("N", FFT_RESOLUTION);
-    shaderNormalMap->setUniform("choppiness", choppiness);
-    shaderNormalMap->setUniform("waveHeight", waveHeight);
+    if (!GaussianRng::knownAnswerTest()) {
+        rngStatus = "CPU generator fails the Philox known answers!";
+        return;
+    }
 
-    glActiveTexture(GL_TEXTURE7);
-    glBindTexture(GL_TEXTURE_2D, texDispY);
-    shaderNormalMap->setUniform("height", 7);
+    shaderGaussian->use();
+    shaderGaussian->setUniform("seed", seed);
+    Core::GLStateCache::bindImageTexture(0, texHkt_dy, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    Core::GLStateCache::bindImageTexture(1, texHkt_dx, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    dispatchCompute(*shaderGaussian, FFT_RESOLUTION, FFT_RESOLUTION);
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+    const size_t texels = size_t(FFT_RESOLUTION) * size_t(FFT_RESOLUTION);
+    std::vector<float> gpuK(texels * 4);
+    std::vector<float> gpuMinusK(texels * 4);
+    glGetTextureImage(texHkt_dy, 0, GL_RGBA, GL_FLOAT, GLsizei(gpuK.size() * sizeof(float)), gpuK.data());
+    glGetTextureImage(texHkt_dx, 0, GL_RGBA, GL_FLOAT, GLsizei(gpuMinusK.size() * sizeof(float)), gpuMinusK.data());
+
+    // the GPU log, sin and cos are not correctly rounded, the tails of Box-Muller amplify their error the most
+    const auto maxError = [&](bool simd) {
+        std::vector<float> cpu;
+        GaussianRng::gaussianField(FFT_RESOLUTION, uint32_t(seed), cpu, simd);
+        float error = 0.0f;
+        for (size_t i = 0; i < texels; i++) {
+            for (int c = 0; c < 2; c++) {
+                error = std::max(error, std::abs(cpu[i * 4 + c] - gpuK[i * 4 + c]));
+                error = std::max(error, std::abs(cpu[i * 4 + 2 + c] - gpuMinusK[i * 4 + c]));
+            }
+        }
+        return error;
+    };
+
+    // both CPU paths against the GPU, the SSE4.1 one only where the CPU has it
+    const float scalarError = maxError(false);
+    const float simdError = GaussianRng::sse41Supported() ? maxError(true) : scalarError;
+    std::ostringstream status;
+    status << (std::max(scalarError, simdError) < 1.0e-3f ? "Match" : "MISMATCH") << ", max difference "
+           << std::scientific << std::setprecision(2);
+    if (GaussianRng::sse41Supported())
+        status << "SSE4.1 " << simdError << ", ";
+    status << "scalar " << scalarError;
+    rngStatus = status.str();
+}
 
-    glDispatchCompute(FFT_RESOLUTION / LOCAL_WORK_GROUP_SIZE, FFT_RESOLUTION / LOCAL_WORK_GROUP_SIZE, 1);
+/*
+ * @brief Compute Normalmap
+ */
+void OceanSurface::renderNormalMap(const Core::ShaderProgram& program) {
+
+    program.use();
+    Core::GLStateCache::bindImageTexture(0, texDispY, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
+    Core::GLStateCache::bindImageTexture(1, texNormalX, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
+    Core::GLStateCache::bindImageTexture(2, texNormalZ, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
+    Core::GLStateCache::bindImageTexture(3, texNormalMap, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    Core::GLStateCache::bindImageTexture(4, texDispX, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
+    Core::GLStateCache::bindImageTexture(5, texDispZ, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
+    Core::GLStateCache::bindImageTexture(6, texFoam[foamIndex], 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+    Core::GLStateCache::bindImageTexture(7, texFoam[1 - foamIndex], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+    program.setUniform("choppiness", choppiness);
+    program.setUniform("waveHeight", waveHeight);
+    // the loop wraps the time around, the foam just does not decay in that frame
+    program.setUniform("dt", std::clamp(time - foamTime, 0.0f, 0.1f));
+    program.setUniform("foamThreshold", foamThreshold);
+    program.setUniform("foamDecay", foamDecay);
+    foamTime = time;
+
+    Core::GLStateCache::bindTextureUnit(7, texDispY);
+    Core::GLStateCache::bindSampler(7, samplerNearest);
+    program.setUniform("height", 7);
+
+    dispatchCompute(program, FFT_RESOLUTION, FFT_RESOLUTION);
     glMemoryBarrier(GL_ALL_BARRIER_BITS);
-    glUseProgram(0);
+    foamIndex = 1 - foamIndex;
 }
 
  /*
  * @brief Compute displacement field by IFFT computation
  */
-void OceanSurface::renderIFFT(GLuint texInp, GLuint texOut) {
+void OceanSurface::renderIFFT(GLuint texInp, GLuint texOut, const WorkGroupTuner::Programs& programs) {
+    renderIFFT(texInp, texOut, programs, texButterfly, FFT_RESOLUTION, 1.0f);
+}
 
-    shaderInverseFFT->use();
-    glBindImageTexture(0, texButterfly, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F); // read precomputed data for butterfly operation
-    glBindImageTexture(1, texInp, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32F); // initial texture to read from
-    glBindImageTexture(2, texPingPong, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32F); // pingpong texture to write to
-    glBindImageTexture(3, texOut, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F); // final output texture
-    shaderInverseFFT->setUniform("inv", false);
+/*
+ * @brief IFFT of the resolution x resolution block of texInp, the final step fills the whole output texture
+ *
+ * blend below 1 mixes the result into the output of the level that is faded out.
+ */
+void OceanSurface::renderIFFT(GLuint texInp, GLuint texOut, const WorkGroupTuner::Programs& programs,
+    GLuint butterfly, int resolution, float blend) {
+
+    Core::GLStateCache::bindImageTexture(0, butterfly, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F); // read precomputed data for butterfly operation
+    Core::GLStateCache::bindImageTexture(1, texInp, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32F); // initial texture to read from
+    Core::GLStateCache::bindImageTexture(2, texPingPong, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32F); // pingpong texture to write to
+    Core::GLStateCache::bindImageTexture(3, texOut, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32F); // final output texture, read while fading
+    const int stages = int(std::log2(resolution));
     int pingPong = 0;
 
-    // 1D FFT Horizontal
-    for (int i = 0; i < butterflyStages; i++) {
-
-        shaderInverseFFT->setUniform("direction", 0);
-        shaderInverseFFT->setUniform("stage", i);
-        shaderInverseFFT->setUniform("pingpong", pingPong);
-
-        // run the compute shader each butterfly step
-        glDispatchCompute(FFT_RESOLUTION / LOCAL_WORK_GROUP_SIZE, FFT_RESOLUTION / LOCAL_WORK_GROUP_SIZE, 1);
-        glMemoryBarrier(GL_ALL_BARRIER_BITS);
-
-        pingPong++;
-        pingPong = pingPong % 2;
-    }
-
-    // output texture of the horizontal 1D FFT is the input for the vertical phase
-    // 1D FFT Vertical
-    for (int i = 0; i < butterflyStages; i++) {
+    // 1D FFT Horizontal, then the output of the horizontal 1D FFT is the input for the vertical phase
+    // direction and pingpong are compiled into the program variants, only the stage is a uniform
+    for (int direction = 0; direction < 2; direction++) {
+        for (int i = 0; i < stages; i++) {
 
-        shaderInverseFFT->setUniform("direction", 1);
-        shaderInverseFFT->setUniform("stage", i);
-        shaderInverseFFT->setUniform("pingpong", pingPong);
+            const Core::ShaderProgram& program = *programs[direction * 2 + pingPong];
+            program.use();
+            program.setUniform("stage", i);
 
-        // run the compute shader each step
-        glDispatchCompute(FFT_RESOLUTION / LOCAL_WORK_GROUP_SIZE, FFT_RESOLUTION / LOCAL_WORK_GROUP_SIZE, 1);
-        glMemoryBarrier(GL_ALL_BARRIER_BITS);
+            // run the compute shader each butterfly step
+            dispatchCompute(program, resolution, resolution);
+            glMemoryBarrier(GL_ALL_BARRIER_BITS);
 
-        pingPong++;
-        pingPong = pingPong % 2;
+            pingPong++;
+            pingPong = pingPong % 2;
+        }
     }
 
     // inverse the FFT
-    shaderInverseFFT->setUniform("inv", true);
-    shaderInverseFFT->setUniform("pingpong", pingPong);
-    shaderInverseFFT->setUniform("N", FFT_RESOLUTION);
-    glDispatchCompute(FFT_RESOLUTION / LOCAL_WORK_GROUP_SIZE, FFT_RESOLUTION / LOCAL_WORK_GROUP_SIZE, 1);
+    programs[4 + pingPong]->use();
+    programs[4 + pingPong]->setUniform("blend", blend);
+    dispatchCompute(*programs[4 + pingPong], FFT_RESOLUTION, FFT_RESOLUTION);
     glMemoryBarrier(GL_ALL_BARRIER_BITS);
 }
 
 /*
  * @brief Compute data for Butterfly operation for FFT computation
  */
-void OceanSurface::renderButterfly() {
+void OceanSurface::renderButterfly(const Core::ShaderProgram& program) {
 
-    shaderButterfly->use();
-    shaderButterfly->setUniform("N", FFT_RESOLUTION);
-    glBindImageTexture(0, texButterfly, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
-    glDispatchCompute(butterflyStages, FFT_RESOLUTION / LOCAL_WORK_GROUP_SIZE, 1);
+    program.use();
+    Core::GLStateCache::bindImageTexture(0, texButterfly, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    dispatchCompute(program, butterflyStages, FFT_RESOLUTION);
     glMemoryBarrier(GL_ALL_BARRIER_BITS);
-    glUseProgram(0);
     initial = false;
 }
 
 /*
  * @brief Compute time-dependent Wave amplitude h(k,t)
  */
-void OceanSurface::renderWaveAmplitude() {
+void OceanSurface::renderWaveAmplitude(const Core::ShaderProgram& program) {
+    renderWaveAmplitude(program, FFT_RESOLUTION);
+}
 
-    shaderAmplitude->use();
-    shaderAmplitude->setUniform("N", FFT_RESOLUTION);
-    shaderAmplitude->setUniform("len", 1000.0f);
-    shaderAmplitude->setUniform("t", float(glfwGetTime()));
-    //std::cout << glfwGetTime() << std::endl;
+/*
+ * @brief Wave amplitudes of the resolution x resolution lowest wave numbers of the initial spectrum
+ */
+void OceanSurface::renderWaveAmplitude(const Core::ShaderProgram& program, int resolution) {
+
+    program.use();
+    program.setUniform("spectrumOffset", (FFT_RESOLUTION - resolution) / 2);
+    program.setUniform("len", PATCH_LENGTH);
+    program.setUniform("t", time);
+    program.setUniform("loopPeriod", loopEnabled ? loopPeriod : 0.0f);
+    program.setUniform("depth", spectrum.dispersionDepth());
     
     // displacement
-    glBindImageTexture(0, texHkt_dy, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
-    glBindImageTexture(1, texHkt_dx, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
-    glBindImageTexture(2, texHkt_dz, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    Core::GLStateCache::bindImageTexture(0, texHkt_dy, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    Core::GLStateCache::bindImageTexture(1, texHkt_dx, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    Core::GLStateCache::bindImageTexture(2, texHkt_dz, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
     // normal
-    glBindImageTexture(3, texSlope_x, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
-    glBindImageTexture(4, texSlope_z, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    Core::GLStateCache::bindImageTexture(3, texSlope_x, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    Core::GLStateCache::bindImageTexture(4, texSlope_z, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
     // initial data
-    glBindImageTexture(5, texH0k, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
-    glBindImageTexture(6, texH0minusk, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
+    Core::GLStateCache::bindImageTexture(5, texH0k, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
+    Core::GLStateCache::bindImageTexture(6, texH0minusk, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
 
-    glDispatchCompute(FFT_RESOLUTION / LOCAL_WORK_GROUP_SIZE, FFT_RESOLUTION / LOCAL_WORK_GROUP_SIZE, 1);
+    dispatchCompute(program, resolution, resolution);
     glMemoryBarrier(GL_ALL_BARRIER_BITS);
-    glUseProgram(0);
+}
+
+/*
+ * @brief Look up the initial spectrum for the current parameters, compute and cache it on a miss
+ */
+void OceanSurface::updateInitialSpectrum() {
+
+    std::vector<float> values = {windSpeed, windDir.x, windDir.y, phillipsConst, suppression};
+    const std::vector<float> spectrumValues = spectrum.parameters();
+    values.insert(values.end(), spectrumValues.begin(), spectrumValues.end());
+    const SpectrumCacheKey key{Core::ShaderPreprocessor::defineString(spectrum.shaderDefines()), values, seed, FFT_RESOLUTION, PATCH_LENGTH};
+
+    const SpectrumCache::Entry* entry = spectrumCache.find(key);
+    if (entry == nullptr) {
+        Core::TextureHandle h0k = createTexture(GL_RGBA, GL_RGBA32F, NULL, "Spectrum cache");
+        Core::TextureHandle h0minusk = createTexture(GL_RGBA, GL_RGBA32F, NULL, "Spectrum cache");
+        renderInitialSpectrum(*spectrumProgram(), h0k, h0minusk);
+        entry = spectrumCache.insert(key, std::move(h0k), std::move(h0minusk),
+            2 * FFT_RESOLUTION * FFT_RESOLUTION * 4 * sizeof(float));
+    }
+    texH0k = entry->texH0k;
+    texH0minusk = entry->texH0minusk;
+
+    // flag to stop rendering after running once
+    change = false;
 }
 
 /*
  * @brief Compute time-indpendent h(k) for the initial spectrum computation
  */
-void OceanSurface::renderInitialSpectrum() {
+void OceanSurface::renderInitialSpectrum(const Core::ShaderProgram& program, GLuint texOutH0k,
+    GLuint texOutH0minusk) {
 
-    shaderPSpectrum->use();
+    program.use();
 
-    // Gaussian Random Variable
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texGaussRnd);
-    shaderPSpectrum->setUniform("gaussRnd", 0);
+    // Gaussian random variables are generated in the shader from the seed
+    program.setUniform("seed", seed);
 
-    shaderPSpectrum->setUniform("N", FFT_RESOLUTION);
-    shaderPSpectrum->setUniform("len", 1000.0f);
-    shaderPSpectrum->setUniform("A", phillipsConst);
-    shaderPSpectrum->setUniform("windDir", windDir);
-    shaderPSpectrum->setUniform("windSpeed", windSpeed);
-    shaderPSpectrum->setUniform("l", suppression);
+    program.setUniform("len", PATCH_LENGTH);
+    program.setUniform("A", phillipsConst);
+    program.setUniform("windDir", windDir);
+    program.setUniform("windSpeed", windSpeed);
+    program.setUniform("l", suppression);
+    spectrum.setUniforms(program);
 
-    glBindImageTexture(0, texH0k, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
-    glBindImageTexture(1, texH0minusk, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    Core::GLStateCache::bindImageTexture(0, texOutH0k, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    Core::GLStateCache::bindImageTexture(1, texOutH0minusk, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
 
-    // processing 512/32 x 512/32 work groups in parallell in the GPU
-    glDispatchCompute(FFT_RESOLUTION / LOCAL_WORK_GROUP_SIZE, FFT_RESOLUTION / LOCAL_WORK_GROUP_SIZE, 1);
+    // one invocation per wave vector, processed in parallell in the GPU
+    dispatchCompute(program, FFT_RESOLUTION, FFT_RESOLUTION);
     glMemoryBarrier(GL_ALL_BARRIER_BITS);
-
-    // flag to stop rendering after running once
-    change = false;
-    glUseProgram(0);
 }
 
 /**
@@ -381,34 +1364,7 @@ void OceanSurface::resize(int width, int height) {
 
     //change viewport according to the new window size
     glViewport(0, 0, width, height);
-}
-
-/*
- * @brief Generate Gaussian distributed random number as a texture data for GPU
- */
-void OceanSurface::GaussianRandomVariable() {
-
-    std::random_device rd{};
-    
-    //std::mt19937 generator;
-    std::minstd_rand generator{rd()};
-  
-    // gaussian random variable with mean 0.0 and standard deviation 1.0
-    std::normal_distribution<float> nd(0.0, 1.0);
-
-    std::vector<float> rndData;
-
-    for (int i = 0; i < FFT_RESOLUTION; i++) {
-        for (int j = 0; j < FFT_RESOLUTION; j++) {
-            rndData.push_back(nd(generator));
-            rndData.push_back(nd(generator));
-            rndData.push_back(nd(generator));
-            rndData.push_back(nd(generator));
-        }
-    }
-
-    // create texture to load data and use it in the GPU
-    texGaussRnd = createTexture(GL_RGBA, GL_RGBA32F, rndData.data());
+    renderScale.resize(width, height);
 }
 
 /*
@@ -430,8 +1386,6 @@ int32_t OceanSurface::bitReverse(int32_t num, int32_t size) {
  */
 void OceanSurface::initFFTData() {
 
-    GaussianRandomVariable();
-
     std::vector<int32_t> reversed;
     int32_t size = log(FFT_RESOLUTION) / log(2);
 
@@ -439,34 +1393,51 @@ void OceanSurface::initFFTData() {
         reversed.push_back(bitReverse(i, size));
     }
 
-    GLuint bitReversed;
-
-    glGenBuffers(1, &bitReversed);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, bitReversed);
-
-    // upload data to ssb
-    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(int32_t) * reversed.size(), reversed.data(), GL_STATIC_READ);
+    // upload data to ssb, the indices never change
+    ssboBitReversed = Core::BufferHandle("Simulation");
+    glNamedBufferStorage(ssboBitReversed, sizeof(int32_t) * reversed.size(), reversed.data(), 0);
+    ssboBitReversed.setBytes(sizeof(int32_t) * reversed.size());
 
     // bind ssb by its base address to be accessible from a shader
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, bitReversed);
-
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    Core::GLStateCache::bindStorageBuffer(0, ssboBitReversed);
 
     std::vector<float> maxMinHeight;
     maxMinHeight.push_back(0.0f);
     maxMinHeight.push_back(0.0f);
 
-    GLuint data;
-    glGenBuffers(1, &data);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, data);
-
-    // upload data to ssb
-    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(float) * 2, maxMinHeight.data(), GL_DYNAMIC_COPY);
+    // upload data to ssb, reset from the CPU when a loop is baked or played
+    ssboHeightRange = Core::BufferHandle("Simulation");
+    glNamedBufferStorage(ssboHeightRange, sizeof(float) * 2, maxMinHeight.data(), GL_DYNAMIC_STORAGE_BIT);
+    ssboHeightRange.setBytes(sizeof(float) * 2);
 
     // bind ssb by its base address to be accessible from a shader
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, data);
+    Core::GLStateCache::bindStorageBuffer(1, ssboHeightRange);
+}
+
+/*
+ * @brief Butterfly data of the reduced resolution levels, their programs are submitted with the others
+ */
+void OceanSurface::initFFTPlans() {
+
+    for (int resolution : resolutionController.levels()) {
+        if (resolution == FFT_RESOLUTION)
+            continue;
 
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        std::vector<int32_t> reversed;
+        const int32_t size = int32_t(std::log2(resolution));
+        for (int i = 0; i < resolution; i++) {
+            reversed.push_back(bitReverse(i, size));
+        }
+
+        FFTPlan& plan = fftPlans[resolution];
+        plan.ssboBitReversed = Core::BufferHandle("Simulation");
+        glNamedBufferStorage(plan.ssboBitReversed, sizeof(int32_t) * reversed.size(), reversed.data(), 0);
+        plan.ssboBitReversed.setBytes(sizeof(int32_t) * reversed.size());
+        // one column per butterfly stage, one row per index
+        plan.texButterfly = Core::TextureHandle(GL_TEXTURE_2D, "Simulation");
+        glTextureStorage2D(plan.texButterfly, 1, GL_RGBA32F, size, resolution);
+        plan.texButterfly.setBytes(size_t(size) * size_t(resolution) * 4 * sizeof(float));
+    }
 }
 
 /*
@@ -474,9 +1445,12 @@ void OceanSurface::initFFTData() {
  */
 void OceanSurface::initTexture() {
 
-    // initial spectrum data
-    texH0k = createTexture(GL_RGBA, GL_RGBA32F, NULL);
-    texH0minusk = createTexture(GL_RGBA, GL_RGBA32F, NULL);
+    initSamplers();
+
+    // initial spectrum data is owned by the spectrum cache and set on the first update
+    texH0k = 0;
+    texH0minusk = 0;
+    // all textures are owning handles, so they are released with the plugin
     // time-dependent spectrum data
     texHkt_dx = createTexture(GL_RGBA, GL_RGBA32F, NULL);
     texHkt_dy = createTexture(GL_RGBA, GL_RGBA32F, NULL);
@@ -493,30 +1467,83 @@ void OceanSurface::initTexture() {
     texNormalZ = createTexture(GL_RGBA, GL_RGBA32F, NULL);
     texNormalMap = createTexture(GL_RGBA, GL_RGBA32F, NULL);
     texPerlin = createTexture(GL_RGBA, GL_RGBA32F, NULL);
+    for (Core::TextureHandle& foam : texFoam) {
+        foam = createTexture(GL_RED, GL_R32F, NULL);
+        glClearTexImage(foam, 0, GL_RED, GL_FLOAT, nullptr); // no foam until the first crest breaks
+    }
+    // shading
+    initFresnelLUT();
 }
 
 /*
- * @brief Create texure and return it
+ * @brief Bake the Fresnel reflectance of the surface shader into a 2D texture over (N.V, |N.L|)
+ *
+ * The analytic path refracts the light direction and evaluates fresnelFull() with the resulting cosines. The
+ * refracted cosine only depends on |N.L|, so both inputs are covered by the two LUT axes.
  */
-GLuint OceanSurface::createTexture(GLenum format, GLenum internalformat, const void* data) {
+void OceanSurface::initFresnelLUT() {
 
-    GLuint texture;
+    const float eta = 1.0f / 1.33f;
+    std::vector<float> lut(FRESNEL_LUT_SIZE * FRESNEL_LUT_SIZE);
 
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    for (int j = 0; j < FRESNEL_LUT_SIZE; j++) {
+        const float NdotL = (float(j) + 0.5f) / float(FRESNEL_LUT_SIZE); // [0,1]
+        // dot(-N, refract(-L, N, eta))
+        const float k = 1.0f - eta * eta * (1.0f - NdotL * NdotL);
+        const float cosT = k < 0.0f ? 0.0f : std::sqrt(k);
+
+        for (int i = 0; i < FRESNEL_LUT_SIZE; i++) {
+            const float NdotV = 2.0f * (float(i) + 0.5f) / float(FRESNEL_LUT_SIZE) - 1.0f; // [-1,1]
+            lut[j * FRESNEL_LUT_SIZE + i] = fresnelFull(NdotV, cosT);
+        }
+    }
+
+    // filtered by samplerLinear
+    texFresnelLUT = Core::TextureHandle(GL_TEXTURE_2D, "Shading");
+    glTextureStorage2D(texFresnelLUT, 1, GL_R32F, FRESNEL_LUT_SIZE, FRESNEL_LUT_SIZE);
+    glTextureSubImage2D(texFresnelLUT, 0, 0, 0, FRESNEL_LUT_SIZE, FRESNEL_LUT_SIZE, GL_RED, GL_FLOAT, lut.data());
+    texFresnelLUT.setBytes(lut.size() * sizeof(float));
+}
+
+/*
+ * @brief Sampler objects for the texture units of the render passes
+ */
+void OceanSurface::initSamplers() {
+
+    const auto createSampler = [](GLenum magFilter, GLenum minFilter) {
+        Core::SamplerHandle sampler("Simulation");
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, magFilter);
+        glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, minFilter);
+        return sampler;
+    };
+    samplerNearest = createSampler(GL_NEAREST, GL_NEAREST); // GL_LINEAR outputs less wavy waves
+    samplerLinear = createSampler(GL_LINEAR, GL_LINEAR);
+    // the KTX2 skybox has mip levels, the PNG skybox only the base level
+    samplerSkybox = createSampler(GL_LINEAR, GL_LINEAR_MIPMAP_LINEAR);
+}
 
-    // texture options
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST); // GL_LINEAR outputs less wavy waves
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+/*
+ * @brief Create texure with immutable storage and return it
+ */
+Core::TextureHandle OceanSurface::createTexture(GLenum format, GLenum internalformat, const void* data,
+    const std::string& category) {
 
-    // create empty texture
-    glTexImage2D(GL_TEXTURE_2D, 0, internalformat, FFT_RESOLUTION, FFT_RESOLUTION, 0, format, GL_FLOAT, data);
+    Core::TextureHandle texture(GL_TEXTURE_2D, category);
+    glTextureStorage2D(texture, 1, internalformat, FFT_RESOLUTION, FFT_RESOLUTION);
+    if (data != nullptr) {
+        glTextureSubImage2D(texture, 0, 0, 0, FFT_RESOLUTION, FFT_RESOLUTION, format, GL_FLOAT, data);
+    }
 
-    // release after use
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // the render passes filter through samplerNearest, this only applies to the GUI preview
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 
+    // the simulation only uses 32 bit float formats
+    const size_t channels = internalformat == GL_R32F ? 1 : internalformat == GL_RG32F ? 2 : 4;
+    texture.setBytes(size_t(FFT_RESOLUTION) * FFT_RESOLUTION * channels * sizeof(float));
     return texture;
 }
 
@@ -548,26 +1575,92 @@ void OceanSurface::initSkybox() {
     glowl::Mesh::VertexDataList<float> vertexDataSkybox{{skyboxVertices, {12, {{3, GL_FLOAT, GL_FALSE, 0}}}}};
     vaSkybox = std::make_unique<glowl::Mesh>(vertexDataSkybox, skyboxIndices, GL_UNSIGNED_INT, GL_TRIANGLES);
    
+    // prefer the block compressed, mip-mapped cubemap made with "--ktx2-cubemap skybox1 skybox1.ktx2"
+    if (std::filesystem::is_regular_file(getResourcePath("skybox1.ktx2"))) {
+        try {
+            texSkybox = getKtx2CubemapResource("skybox1.ktx2");
+            return;
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << " Falling back to PNG skybox." << std::endl;
+        }
+    }
+
     std::string skyboxes[6] = {"right.png", "left.png", "top.png", "bottom.png", "front.png", "back.png"};
     
-    glGenTextures(1, &texSkybox);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, texSkybox);
-    // texture options
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-
-    // load data to cubemap for each directions
+    // the storage is allocated with the first decoded face, when the face size is known
+    texSkybox = Core::TextureHandle(GL_TEXTURE_CUBE_MAP, "Skybox");
+
+    // decode all faces in parallel, uploadSkyboxFaces() moves them to the cubemap as they become ready
     for (int i = 0; i < 6; i++) {
-        std::string path = "skybox1/" + skyboxes[i];
-        int width, height;
-        auto image = getPngResource(path, width, height);
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
-            (const void*) &image[0]);
+        skyboxFaces[i] = loadPngAsync("skybox1/" + skyboxes[i]);
+    }
+    skyboxFaceFailed.fill(false);
+    skyboxFacesPending = 6;
+    skyboxFaceSize = 0;
+    pboSkybox = Core::BufferHandle("Streaming");
+}
+
+/*
+ * @brief Upload at most one decoded skybox face per frame through a pixel unpack buffer
+ *
+ * A face that fails to decode is logged and uploaded in a plain color instead, so the skybox still completes.
+ * Its size is taken from the first decoded face, or 1x1 when no face could be decoded.
+ */
+void OceanSurface::uploadSkyboxFaces() {
+
+    if (skyboxFacesPending == 0)
+        return;
+
+    const auto failed = static_cast<int>(std::count(skyboxFaceFailed.begin(), skyboxFaceFailed.end(), true));
+    for (int i = 0; i < 6; i++) {
+        Core::PngImage image;
+        if (skyboxFaceFailed[i]) {
+            // wait for the size of a decoded face, unless no face is left to decode
+            if (skyboxFaceSize == 0 && failed < skyboxFacesPending)
+                continue;
+            const int faceSize = std::max(skyboxFaceSize, 1);
+            const unsigned char color[4] = SKYBOX_FALLBACK_COLOR;
+            image = {std::vector<unsigned char>(size_t(faceSize) * size_t(faceSize) * 4), faceSize, faceSize};
+            for (size_t t = 0; t < image.data.size(); t += 4) {
+                std::memcpy(&image.data[t], color, 4);
+            }
+            skyboxFaceFailed[i] = false;
+        } else {
+            if (!skyboxFaces[i].valid() ||
+                skyboxFaces[i].wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                continue;
+            try {
+                image = skyboxFaces[i].get(); // rethrows decoding errors
+            } catch (const std::exception& e) {
+                std::cerr << "Skybox face " << i << ": " << e.what() << " Using a plain color instead." << std::endl;
+                skyboxFaceFailed[i] = true;
+                continue;
+            }
+        }
+        const auto size = static_cast<GLsizeiptr>(image.data.size());
+
+        // orphan the buffer, the previous face may still be transferred. Orphaning needs mutable storage.
+        glNamedBufferData(pboSkybox, size, nullptr, GL_STREAM_DRAW);
+        pboSkybox.setBytes(image.data.size());
+        void* ptr = glMapNamedBufferRange(pboSkybox, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        std::memcpy(ptr, image.data.data(), image.data.size());
+        glUnmapNamedBuffer(pboSkybox);
+
+        if (skyboxFacesPending == 6) {
+            skyboxFaceSize = image.width;
+            glTextureStorage2D(texSkybox, 1, GL_RGBA8, image.width, image.height);
+            texSkybox.setBytes(image.data.size() * 6);
+        }
+        // faces of a cubemap with immutable storage are layers, source is offset 0 of the bound unpack buffer
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pboSkybox);
+        glTextureSubImage3D(texSkybox, 0, 0, 0, i, image.width, image.height, 1, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        skyboxFacesPending--;
+        if (skyboxFacesPending == 0)
+            pboSkybox.reset();
+        break;
     }
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 }
 
 /*
@@ -649,64 +1742,304 @@ void OceanSurface::initVA() {
  */
 void OceanSurface::initShaders() {
 
-    try {
-        shaderOceanSurface = std::make_unique<glowl::GLSLProgram>(glowl::GLSLProgram::ShaderSourceList{
-            {glowl::GLSLProgram::ShaderType::Vertex, getStringResource("shaders/OceanSurface.vert")},
-           // {glowl::GLSLProgram::ShaderType::Geometry, getStringResource("shaders/OceanSurface.geom")},
-            {glowl::GLSLProgram::ShaderType::Fragment, getStringResource("shaders/OceanSurface.frag")}});
-    } catch (glowl::GLSLProgramException& e) {
-        std::cerr << e.what() << std::endl;
-    }
+    using ShaderType = Core::ShaderProgram::ShaderType;
+
+    // submitted in the order the passes should become available, the skybox can be shown first
+    initSurfaceShaders();
+    const Core::ShaderPreprocessor::Defines viewDefines{{"MAX_VIEWS", std::to_string(MAX_VIEWS)}};
+    shaderManager.submit(shaderBody, "Body",
+        {{ShaderType::Vertex, getShaderResource("shaders/Body.vert", viewDefines)},
+            {ShaderType::Fragment, getShaderResource("shaders/Body.frag")}});
+    shaderManager.submit(shaderSpray, "Spray",
+        {{ShaderType::Vertex, getShaderResource("shaders/Spray.vert", viewDefines)},
+            {ShaderType::Fragment, getShaderResource("shaders/Spray.frag")}});
+    shaderManager.submit(shaderUpscale, "Upscale",
+        {{ShaderType::Vertex, getShaderResource("shaders/Upscale.vert")},
+            {ShaderType::Fragment, getShaderResource("shaders/Upscale.frag")}});
+    initComputeShaders();
+}
 
-    try {
-        shaderSkybox = std::make_unique<glowl::GLSLProgram>(glowl::GLSLProgram::ShaderSourceList{
-            {glowl::GLSLProgram::ShaderType::Vertex, getStringResource("shaders/Skybox.vert")},
-            {glowl::GLSLProgram::ShaderType::Fragment, getStringResource("shaders/Skybox.frag")}});
-    } catch (glowl::GLSLProgramException& e) {
-        std::cerr << e.what() << std::endl;
-    }
+/*
+ * @brief Submit the skybox and surface shaders, the texture binding model is compiled in
+ */
+void OceanSurface::initSurfaceShaders() {
+
+    using ShaderType = Core::ShaderProgram::ShaderType;
+
+    // a program of the other binding model must not be drawn until the new one is compiled
+    shaderSkybox.reset();
+    shaderOceanSurface.reset();
+
+    Core::ShaderPreprocessor::Defines defines{
+        {"MAX_WAKE_REGIONS", std::to_string(WAKE_MAX_REGIONS)}, {"MAX_VIEWS", std::to_string(MAX_VIEWS)}};
+    if (bindless)
+        defines.emplace_back("BINDLESS", "1");
+    if (viewInstancing)
+        defines.emplace_back("VIEW_INSTANCING", "1");
+
+    shaderManager.submit(shaderSkybox, "Skybox",
+        {{ShaderType::Vertex, getShaderResource("shaders/Skybox.vert", defines)},
+            {ShaderType::Fragment, getShaderResource("shaders/Skybox.frag", defines)}});
+    shaderManager.submit(shaderOceanSurface, "OceanSurface",
+        {{ShaderType::Vertex, getShaderResource("shaders/OceanSurface.vert", defines)},
+            {ShaderType::Fragment, getShaderResource("shaders/OceanSurface.frag", defines)}});
+}
 
-    // shader program for compute shaders
-    try {
-        shaderPSpectrum = std::make_unique<glowl::GLSLProgram>(glowl::GLSLProgram::ShaderSourceList{
-            {glowl::GLSLProgram::ShaderType::Compute, getStringResource("shaders/PhillipsSpectrum.comp")}});
-    } catch (glowl::GLSLProgramException& e) {
-        std::cerr << e.what() << std::endl;
-    }
+/*
+ * @brief Make the surface textures resident once the skybox is complete
+ */
+void OceanSurface::updateTextureTable() {
+
+    if (!bindless || textureTable || skyboxFacesPending > 0)
+        return;
+
+    textureTable = std::make_unique<Core::BindlessTextureTable>(size_t(TextureSlot::Count));
+    textureTable->set(size_t(TextureSlot::DispY), texDispY, samplerNearest);
+    textureTable->set(size_t(TextureSlot::DispX), texDispX, samplerNearest);
+    textureTable->set(size_t(TextureSlot::DispZ), texDispZ, samplerNearest);
+    textureTable->set(size_t(TextureSlot::NormalMap), texNormalMap, samplerNearest);
+    textureTable->set(size_t(TextureSlot::Perlin), texPerlin, samplerNearest);
+    textureTable->set(size_t(TextureSlot::FresnelLUT), texFresnelLUT, samplerLinear);
+    textureTable->set(size_t(TextureSlot::Skybox), texSkybox, samplerSkybox);
+    textureTable->set(size_t(TextureSlot::Foam0), texFoam[0], samplerLinear);
+    textureTable->set(size_t(TextureSlot::Foam1), texFoam[1], samplerLinear);
+    textureTable->set(size_t(TextureSlot::Wake0), wake.texture(0), samplerLinear);
+    textureTable->set(size_t(TextureSlot::Wake1), wake.texture(1), samplerLinear);
+}
 
-    try {
-        shaderAmplitude = std::make_unique<glowl::GLSLProgram>(glowl::GLSLProgram::ShaderSourceList{
-            {glowl::GLSLProgram::ShaderType::Compute, getStringResource("shaders/WaveAmplitude.comp")}});
-    } catch (glowl::GLSLProgramException& e) {
-        std::cerr << e.what() << std::endl;
+/*
+ * @brief Submit the compute shaders, the FFT size and the tuned work group sizes are compile time constants
+ */
+void OceanSurface::initComputeShaders() {
+
+    using ShaderType = Core::ShaderProgram::ShaderType;
+
+    initSpectrumShader();
+    shaderManager.submit(shaderGaussian, "GaussianField",
+        {{ShaderType::Compute, getShaderResource("shaders/PhillipsSpectrum.comp",
+                                   computeDefines(workGroupSize(ComputePass::Spectrum), {{"GAUSSIAN_FIELD", ""}}))}});
+    shaderManager.submit(shaderAmplitude, "WaveAmplitude",
+        {{ShaderType::Compute,
+            getShaderResource("shaders/WaveAmplitude.comp", computeDefines(workGroupSize(ComputePass::Amplitude)))}});
+    shaderManager.submit(shaderButterfly, "ButterflyFactor",
+        {{ShaderType::Compute,
+            getShaderResource("shaders/ButterflyFactor.comp", computeDefines(workGroupSize(ComputePass::Butterfly)))}});
+    shaderInverseFFT.resize(6);
+    for (int i = 0; i < 6; i++) {
+        shaderManager.submit(shaderInverseFFT[i], "InverseFFT",
+            {{ShaderType::Compute,
+                getShaderResource("shaders/InverseFFT.comp",
+                    computeDefines(workGroupSize(ComputePass::InverseFFT), inverseFFTDefines(i)))}});
     }
-
-    try {
-        shaderButterfly = std::make_unique<glowl::GLSLProgram>(glowl::GLSLProgram::ShaderSourceList{
-            {glowl::GLSLProgram::ShaderType::Compute, getStringResource("shaders/ButterflyFactor.comp")}});
-    } catch (glowl::GLSLProgramException& e) {
-        std::cerr << e.what() << std::endl;
+    for (auto& [resolution, plan] : fftPlans) {
+        shaderManager.submit(plan.amplitude, "WaveAmplitude",
+            {{ShaderType::Compute, getShaderResource("shaders/WaveAmplitude.comp",
+                                       computeDefines(workGroupSize(ComputePass::Amplitude), {}, resolution))}});
+        shaderManager.submit(plan.butterfly, "ButterflyFactor",
+            {{ShaderType::Compute, getShaderResource("shaders/ButterflyFactor.comp",
+                                       computeDefines(workGroupSize(ComputePass::Butterfly), {}, resolution))}});
+        plan.inverseFFT.resize(6);
+        for (int i = 0; i < 6; i++) {
+            shaderManager.submit(plan.inverseFFT[i], "InverseFFT",
+                {{ShaderType::Compute,
+                    getShaderResource("shaders/InverseFFT.comp",
+                        computeDefines(workGroupSize(ComputePass::InverseFFT), inverseFFTDefines(i), resolution))}});
+        }
     }
+    shaderManager.submit(shaderPerlinNoise, "PerlinNoise",
+        {{ShaderType::Compute,
+            getShaderResource("shaders/PerlinNoise.comp", computeDefines(workGroupSize(ComputePass::PerlinNoise)))}});
+    shaderManager.submit(shaderNormalMap, "NormalMap",
+        {{ShaderType::Compute,
+            getShaderResource("shaders/NormalMap.comp", computeDefines(workGroupSize(ComputePass::NormalMap)))}});
+    shaderManager.submit(shaderQuery, "OceanQuery",
+        {{ShaderType::Compute,
+            getShaderResource("shaders/OceanQuery.comp", computeDefines(glm::ivec2(QUERY_WORK_GROUP_SIZE, 1)))}});
+    shaderManager.submit(shaderBuoyancy, "Buoyancy",
+        {{ShaderType::Compute,
+            getShaderResource("shaders/Buoyancy.comp", computeDefines(glm::ivec2(BODY_WORK_GROUP_SIZE, 1)))}});
+    const std::string wakeRegionCount = std::to_string(WAKE_MAX_REGIONS);
+    shaderManager.submit(shaderWakeInject, "WakeInject",
+        {{ShaderType::Compute,
+            getShaderResource("shaders/Wake.comp", computeDefines(glm::ivec2(WAKE_INJECT_WORK_GROUP_SIZE, 1),
+                {{"MAX_WAKE_REGIONS", wakeRegionCount}, {"INJECT", ""}}))}});
+    shaderManager.submit(shaderWakeStep, "WakeStep",
+        {{ShaderType::Compute,
+            getShaderResource("shaders/Wake.comp", computeDefines(glm::ivec2(WAKE_WORK_GROUP_SIZE),
+                {{"MAX_WAKE_REGIONS", wakeRegionCount}, {"STEP", ""}}))}});
+    shaderManager.submit(shaderSprayEmit, "SprayEmit",
+        {{ShaderType::Compute,
+            getShaderResource("shaders/Spray.comp",
+                computeDefines(glm::ivec2(SPRAY_EMIT_WORK_GROUP_SIZE), {{"EMIT", ""}}))}});
+    shaderManager.submit(shaderSpraySimulate, "SpraySimulate",
+        {{ShaderType::Compute,
+            getShaderResource("shaders/Spray.comp",
+                computeDefines(glm::ivec2(SPRAY_WORK_GROUP_SIZE, 1), {{"SIMULATE", ""}}))}});
+    shaderManager.submit(shaderSprayFinalize, "SprayFinalize",
+        {{ShaderType::Compute,
+            getShaderResource("shaders/Spray.comp", computeDefines(glm::ivec2(1), {{"FINALIZE", ""}}))}});
+}
 
-    try {
-        shaderInverseFFT = std::make_unique<glowl::GLSLProgram>(glowl::GLSLProgram::ShaderSourceList{
-             {glowl::GLSLProgram::ShaderType::Compute, getStringResource("shaders/InverseFFT.comp")}});
-    } catch (glowl::GLSLProgramException& e) {
-        std::cerr << e.what() << std::endl;
+/*
+ * @brief World space mapping of the displacement textures for the height queries
+ *
+ * The Perlin noise amplitude depends on the camera distance, queries use the unmodulated surface.
+ */
+OceanQuery::Surface OceanSurface::querySurface() const {
+
+    const glm::vec3 origin = glm::vec3(surfaceModelMx() * glm::vec4(-GRID_SIZE / 2.0f, 0.0f, -GRID_SIZE / 2.0f, 1.0f));
+    OceanQuery::Surface surface{};
+    surface.origin = glm::vec2(origin.x, origin.z);
+    surface.texelSize = 1.0f; // unit grid spacing and one texel per grid cell, see initGrid()
+    surface.choppiness = choppiness;
+    surface.waveHeight = waveHeight;
+    surface.iterations = QUERY_ITERATIONS;
+    return surface;
+}
+
+/*
+ * @brief Measure the CPU sampler on random points over the patch, and check the AVX2 path against the scalar one
+ */
+void OceanSurface::benchmarkMirror() {
+
+    if (!mirror->field()) {
+        mirrorStatus = "No field yet";
+        return;
     }
 
-    try {
-        shaderPerlinNoise = std::make_unique<glowl::GLSLProgram>(glowl::GLSLProgram::ShaderSourceList{
-            {glowl::GLSLProgram::ShaderType::Compute, getStringResource("shaders/PerlinNoise.comp")}});
-    } catch (glowl::GLSLProgramException& e) {
-        std::cerr << e.what() << std::endl;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> dist(-GRID_SIZE / 2.0f, GRID_SIZE / 2.0f);
+    std::vector<glm::vec2> points(1 << 20);
+    for (glm::vec2& p : points)
+        p = glm::vec2(dist(rng), dist(rng));
+    std::vector<float> reference(points.size());
+    std::vector<float> heights(points.size());
+
+    // M samples per second of one sampler
+    const auto measure = [&points](const auto& sample, std::vector<float>& out) {
+        const auto start = std::chrono::steady_clock::now();
+        sample(points.data(), points.size(), out.data());
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return double(points.size()) / seconds * 1e-6;
+    };
+
+    std::ostringstream status;
+    status << std::fixed << std::setprecision(1);
+    const double scalarRate = measure(
+        [this](const glm::vec2* p, std::size_t n, float* h) { mirror->sampleHeightScalar(p, n, h); }, reference);
+    status << "Scalar " << scalarRate << " M samples/s";
+
+    if (DisplacementMirror::avx2Supported()) {
+        const double avx2Rate = measure(
+            [this](const glm::vec2* p, std::size_t n, float* h) { mirror->sampleHeight(p, n, h); }, heights);
+
+        // FMA rounds once where the scalar path rounds twice; the choppy inversion carries that into the sample
+        // position, on steep fields up to a few 1e-4 of the largest height
+        float maxError = 0.0f;
+        float maxHeight = 0.0f;
+        for (size_t i = 0; i < points.size(); i++) {
+            maxError = std::max(maxError, std::abs(heights[i] - reference[i]));
+            maxHeight = std::max(maxHeight, std::abs(reference[i]));
+        }
+        const bool match = maxError <= 1.0e-3f * std::max(maxHeight, 1.0f);
+        status << ", AVX2 " << avx2Rate << " M samples/s (" << std::setprecision(2) << avx2Rate / scalarRate
+               << "x), " << (match ? "match" : "MISMATCH") << ", max difference " << std::scientific << maxError;
+    } else {
+        status << ", no AVX2";
     }
+    mirrorStatus = status.str();
+}
 
-    try {
-        shaderNormalMap = std::make_unique<glowl::GLSLProgram>(glowl::GLSLProgram::ShaderSourceList{
-            {glowl::GLSLProgram::ShaderType::Compute, getStringResource("shaders/NormalMap.comp")}});
-    } catch (glowl::GLSLProgramException& e) {
-        std::cerr << e.what() << std::endl;
+/*
+ * @brief Keep one query of the GUI probe in flight, take its result once it arrived
+ */
+void OceanSurface::updateProbe() {
+
+    if (probeTicket != 0) {
+        std::vector<OceanQuery::Result> results;
+        if (!oceanQuery.results(probeTicket, results))
+            return;
+        probeResult = results.front();
+        probeValid = true;
     }
+    probeTicket = oceanQuery.submit({probePoint});
+}
+
+/*
+ * @brief Compile the spectrum variant for the current spectrum type, spreading function and swell setting
+ */
+void OceanSurface::initSpectrumShader() {
+
+    // variants are kept per define set, switching back to a spectrum compiled before needs no compile
+    const Core::ShaderPreprocessor::Defines defines = spectrumDefines();
+    std::unique_ptr<Core::ShaderProgram>& program = shaderPSpectrum[Core::ShaderPreprocessor::defineString(defines)];
+    if (program)
+        return;
+    shaderManager.submit(program, "PhillipsSpectrum",
+        {{Core::ShaderProgram::ShaderType::Compute, getShaderResource("shaders/PhillipsSpectrum.comp", defines)}});
 }
 
+/*
+ * @brief Register the compute passes with their work group candidates at the tuner
+ *
+ * The candidates are compiled in the background by the ShaderManager and run on the live textures once linked.
+ * Every pass either reproduces its current output or writes data the next renderSimulation() recomputes; the
+ * spectrum pass writes into the time-dependent amplitudes, its own output belongs to the spectrum cache.
+ */
+void OceanSurface::initWorkGroupTuner() {
+
+    using Programs = WorkGroupTuner::Programs;
+    using Defines = Core::ShaderPreprocessor::Defines;
+
+    const glm::ivec2 fallback(LOCAL_WORK_GROUP_SIZE, LOCAL_WORK_GROUP_SIZE);
+    const std::vector<glm::ivec2> candidates = {
+        {8, 8}, {16, 8}, {16, 16}, {32, 4}, {32, 8}, {32, 16}, {32, 32}, {64, 4}};
+    // the x axis of the butterfly texture are the log2(N) stages, one invocation per stage
+    const std::vector<glm::ivec2> butterflyCandidates = {{1, 16}, {1, 32}, {1, 64}, {1, 128}, {1, 256}};
+
+    // candidates are compiled in the background like every other program, the tuner waits for them
+    const auto compile = [this](const std::string& name, const Defines& defines, Programs& programs) {
+        programs.resize(1);
+        shaderManager.submit(programs[0], name,
+            {{Core::ShaderProgram::ShaderType::Compute, getShaderResource("shaders/" + name + ".comp", defines)}});
+    };
+
+    tuner.addPass("PhillipsSpectrum", fallback, candidates,
+        [this, compile](glm::ivec2 size, Programs& programs) {
+            compile("PhillipsSpectrum", computeDefines(size, spectrum.shaderDefines()), programs);
+        },
+        // texH0k and texH0minusk belong to the spectrum cache, the candidates write into the time-dependent
+        // amplitudes instead, which every frame rewrites
+        [this](const Programs& programs) { renderInitialSpectrum(*programs[0], texHkt_dy, texHkt_dx); });
+    tuner.addPass("WaveAmplitude", fallback, candidates,
+        [this, compile](glm::ivec2 size, Programs& programs) {
+            compile("WaveAmplitude", computeDefines(size), programs);
+        },
+        [this](const Programs& programs) { renderWaveAmplitude(*programs[0]); });
+    tuner.addPass("ButterflyFactor", glm::ivec2(1, LOCAL_WORK_GROUP_SIZE), butterflyCandidates,
+        [this, compile](glm::ivec2 size, Programs& programs) {
+            compile("ButterflyFactor", computeDefines(size), programs);
+        },
+        [this](const Programs& programs) { renderButterfly(*programs[0]); });
+    tuner.addPass("InverseFFT", fallback, candidates,
+        [this](glm::ivec2 size, Programs& programs) {
+            // sized before the first submit, the ShaderManager keeps pointers to the elements
+            programs.resize(6);
+            for (int i = 0; i < 6; i++) {
+                shaderManager.submit(programs[i], "InverseFFT",
+                    {{Core::ShaderProgram::ShaderType::Compute,
+                        getShaderResource("shaders/InverseFFT.comp", computeDefines(size, inverseFFTDefines(i)))}});
+            }
+        },
+        [this](const Programs& programs) { renderIFFT(texHkt_dy, texDispY, programs); });
+    tuner.addPass("NormalMap", fallback, candidates,
+        [this, compile](glm::ivec2 size, Programs& programs) {
+            compile("NormalMap", computeDefines(size), programs);
+        },
+        [this](const Programs& programs) { renderNormalMap(*programs[0]); });
+    tuner.addPass("PerlinNoise", fallback, candidates,
+        [this, compile](glm::ivec2 size, Programs& programs) {
+            compile("PerlinNoise", computeDefines(size), programs);
+        },
+        [this](const Programs& programs) { renderPerlinNoise(*programs[0]); });
+}
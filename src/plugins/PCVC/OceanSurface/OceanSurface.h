@@ -1,5 +1,9 @@
 #pragma once
 
+#include <array>
+#include <functional>
+#include <future>
+#include <map>
 #include <string>
 #include <iostream>
 #include <fstream>
@@ -15,6 +19,21 @@
 #include "core/PluginRegister.h"
 #include "core/RenderPlugin.h"
 #include "core/camera/OrbitCamera.h"
+#include "core/shader/ShaderManager.h"
+#include "core/util/BindlessTextureTable.h"
+#include "BuoyancySystem.h"
+#include "DisplacementCache.h"
+#include "DisplacementMirror.h"
+#include "OceanQuery.h"
+#include "PerlinNoise.h"
+#include "RenderScale.h"
+#include "ResolutionController.h"
+#include "SpraySystem.h"
+#include "ViewSet.h"
+#include "WakeSolver.h"
+#include "Spectrum.h"
+#include "SpectrumCache.h"
+#include "WorkGroupTuner.h"
 
 #include <glm/gtx/string_cast.hpp>
 
@@ -33,35 +52,77 @@ namespace OGL4Core2::Plugins::PCVC::OceanSurface {
 
         void render() override;
         void resize(int width, int height) override;
+        // the frame is one simulation followed by the draws of all views
+        void simulate(float simulationTime);
+        void draw(const ViewSet::Batch& batch);
         //void keyboard(Core::Key key, Core::KeyAction action, Core::Mods mods) override;
         //void mouseButton(Core::MouseButton button, Core::MouseButtonAction action, Core::Mods mods) override;
         //void mouseMove(double xpos, double ypos) override;
-        void GaussianRandomVariable();
         void renderGUI();
         void initTexture();
+        void initSamplers();
         void initVA();
         void initShaders();
+        void initSurfaceShaders();
+        void initComputeShaders();
+        void initSpectrumShader();
+        void updateSpectrumProgram();
+        void initWorkGroupTuner();
         void initSkybox();
+        void uploadSkyboxFaces();
+        void updateTextureTable();
+        void updateProbe();
+        void benchmarkMirror();
+        [[nodiscard]] OceanQuery::Surface querySurface() const;
         void initFFTData();
         void initGrid();
+        void initFresnelLUT();
+        void bakeLoop();
 
         // render functions
-        void renderInitialSpectrum();
-        void renderWaveAmplitude();
-        void renderIFFT(GLuint texInp, GLuint texOut);
-        void renderSkybox();
-        void renderButterfly();
-        void renderNormalMap();
-        void renderPerlinNoise();
-
-        GLuint createTexture(GLenum format, GLenum internalformat, const void* data);
+        void updateInitialSpectrum();
+        void renderInitialSpectrum(const Core::ShaderProgram& program, GLuint texOutH0k, GLuint texOutH0minusk);
+        void renderWaveAmplitude(const Core::ShaderProgram& program);
+        void renderWaveAmplitude(const Core::ShaderProgram& program, int resolution);
+        void renderSimulation(bool adaptive = true);
+        bool renderSpectrumLevel(int resolution, float blend);
+        void updateResolution();
+        void initFFTPlans();
+        void renderOceanSurface(const ViewSet::Batch& batch);
+        void simulateBodies();
+        void renderBodies(int view);
+        void spawnBodies();
+        void updateSpray();
+        void updateWakeSources();
+        void updateWake();
+        void renderSpray(int view);
+        [[nodiscard]] std::vector<ViewSet::View> collectViews() const;
+        [[nodiscard]] glm::ivec2 renderSize() const;
+        [[nodiscard]] glm::vec3 lightDirection() const;
+        [[nodiscard]] bool simulationReady() const;
+        [[nodiscard]] Core::ShaderProgram* spectrumProgram() const;
+        [[nodiscard]] Core::ShaderPreprocessor::Defines spectrumDefines() const;
+
+        // compute passes with a tuned work group size, in the order they are added to the tuner
+        enum class ComputePass { Spectrum, Amplitude, Butterfly, InverseFFT, NormalMap, PerlinNoise };
+        [[nodiscard]] glm::ivec2 workGroupSize(ComputePass pass) const {
+            return tuner.size(static_cast<int>(pass));
+        }
+
+        void renderIFFT(GLuint texInp, GLuint texOut, const WorkGroupTuner::Programs& programs);
+        void renderIFFT(GLuint texInp, GLuint texOut, const WorkGroupTuner::Programs& programs, GLuint butterfly,
+            int resolution, float blend);
+        void renderSkybox(int view);
+        void renderButterfly(const Core::ShaderProgram& program);
+        void renderNormalMap(const Core::ShaderProgram& program);
+        void renderPerlinNoise(const Core::ShaderProgram& program);
+
+        Core::TextureHandle createTexture(GLenum format, GLenum internalformat, const void* data,
+            const std::string& category = "Simulation");
         int32_t bitReverse(int32_t num, int32_t size);
 
-        std::vector<float> randomGradient(int ix, int iy);
-        float dotGridGradient(int ix, int iy, float x, float y);
-        float Perlin(float x, float y);
-        float interpolate(float a0, float a1, float w);
-        void initPerlin();
+        void validatePerlinNoise();
+        void validateRandomNumbers();
         
     private:
         
@@ -71,7 +132,7 @@ namespace OGL4Core2::Plugins::PCVC::OceanSurface {
         // GUI parameters
         glm::vec3 backgroundColor;
         int currGUItex;
-        std::vector<GLuint> textures_GUI;
+        std::vector<std::function<GLuint()>> textures_GUI;
         const char* tex_list;
         std::shared_ptr<Core::OrbitCamera> camera; //!< view matrix
         glm::mat4 projMx;
@@ -80,36 +141,91 @@ namespace OGL4Core2::Plugins::PCVC::OceanSurface {
         std::unique_ptr<glowl::Mesh> vaSkybox;
         std::unique_ptr<glowl::Mesh> vaOceanSurface;
 
-        // shader program 
-        std::unique_ptr<glowl::GLSLProgram> shaderQuad; // shaders for quad
-        std::unique_ptr<glowl::GLSLProgram> shaderPSpectrum; // #1 compute shader for Phillips SPectrum
-        std::unique_ptr<glowl::GLSLProgram> shaderAmplitude; // #2 compute shader for Wave Amplitude
-        std::unique_ptr<glowl::GLSLProgram> shaderButterfly; // #3 compute shader for Twiddle factors and indices for butterfly opeation
-        std::unique_ptr<glowl::GLSLProgram> shaderInverseFFT; // #4 compute shader for Butterfly operation of FFT
-        std::unique_ptr<glowl::GLSLProgram> shaderPerlinNoise; // #5 compute shader for Inverse FFT
-        std::unique_ptr<glowl::GLSLProgram> shaderOceanSurface; // shaders for ocean surface
-        std::unique_ptr<glowl::GLSLProgram> shaderSkybox; // shaders for skybox
-        std::unique_ptr<glowl::GLSLProgram> shaderNormalMap;       // shaders for skybox
+        // shader program, compiled in the background by shaderManager, empty until ready
+        Core::ShaderManager shaderManager;
+        WorkGroupTuner tuner; // work group sizes of the compute passes, tuned per GPU
+        std::unique_ptr<Core::ShaderProgram> shaderQuad; // shaders for quad
+        std::map<std::string, std::unique_ptr<Core::ShaderProgram>> shaderPSpectrum; // #1 compute shader for Phillips SPectrum, one variant per spectrum defines
+        std::string spectrumKey;     // variant in use, it follows the requested one once that is linked
+        std::string spectrumVariant; // spectrum defines of spectrumKey without the work group size, the cache key
+        std::unique_ptr<Core::ShaderProgram> shaderGaussian; // raw random numbers of the spectrum pass, for validation
+        std::unique_ptr<Core::ShaderProgram> shaderAmplitude; // #2 compute shader for Wave Amplitude
+        std::unique_ptr<Core::ShaderProgram> shaderButterfly; // #3 compute shader for Twiddle factors and indices for butterfly opeation
+        WorkGroupTuner::Programs shaderInverseFFT; // #4 compute shader for Butterfly operation of FFT, variants direction * 2 + pingpong, 4 + pingpong for the final step
+        std::unique_ptr<Core::ShaderProgram> shaderPerlinNoise; // #5 compute shader for Inverse FFT
+        std::unique_ptr<Core::ShaderProgram> shaderOceanSurface; // shaders for ocean surface
+        std::unique_ptr<Core::ShaderProgram> shaderSkybox; // shaders for skybox
+        std::unique_ptr<Core::ShaderProgram> shaderNormalMap;       // shaders for skybox
+        std::unique_ptr<Core::ShaderProgram> shaderQuery; // resolves batched height queries
+        std::unique_ptr<Core::ShaderProgram> shaderBuoyancy; // integrates the floating bodies
+        std::unique_ptr<Core::ShaderProgram> shaderBody; // draws the floating bodies instanced
+        std::unique_ptr<Core::ShaderProgram> shaderSprayEmit; // spray passes, variants of Spray.comp
+        std::unique_ptr<Core::ShaderProgram> shaderSpraySimulate;
+        std::unique_ptr<Core::ShaderProgram> shaderSprayFinalize;
+        std::unique_ptr<Core::ShaderProgram> shaderSpray; // draws the spray indirectly
+        std::unique_ptr<Core::ShaderProgram> shaderUpscale; // scaled scene into the window
+        std::unique_ptr<Core::ShaderProgram> shaderWakeInject; // wake passes, variants of Wake.comp
+        std::unique_ptr<Core::ShaderProgram> shaderWakeStep;
 
         // texture
-        GLuint texH0k;
-        GLuint texH0minusk;
-        GLuint texGaussRnd;
-        GLuint texHkt_dx;
-        GLuint texHkt_dy;
-        GLuint texHkt_dz;
-        GLuint texSlope_x;
-        GLuint texSlope_z;
-        GLuint texButterfly;
-        GLuint texPingPong;
-        GLuint texDispX;
-        GLuint texDispY;
-        GLuint texDispZ;
-        GLuint texNormalX;
-        GLuint texNormalZ;
-        GLuint texNormalMap;
-        GLuint texSkybox;
-        GLuint texPerlin;
+        GLuint texH0k; // owned by spectrumCache
+        GLuint texH0minusk; // owned by spectrumCache
+        Core::TextureHandle texHkt_dx;
+        Core::TextureHandle texHkt_dy;
+        Core::TextureHandle texHkt_dz;
+        Core::TextureHandle texSlope_x;
+        Core::TextureHandle texSlope_z;
+        Core::TextureHandle texButterfly;
+        Core::TextureHandle texPingPong;
+        Core::TextureHandle texDispX;
+        Core::TextureHandle texDispY;
+        Core::TextureHandle texDispZ;
+        Core::TextureHandle texNormalX;
+        Core::TextureHandle texNormalZ;
+        Core::TextureHandle texNormalMap;
+        Core::TextureHandle texSkybox;
+        Core::TextureHandle texPerlin;
+        Core::TextureHandle texFresnelLUT;
+        std::array<Core::TextureHandle, 2> texFoam; // ping-pong, written by the normal pass
+        WakeSolver wake; // owns the wake textures, declared before the texture table
+
+        // sampler objects, the textures only hold their storage
+        Core::SamplerHandle samplerNearest; // simulation results
+        Core::SamplerHandle samplerLinear; // Fresnel LUT
+        Core::SamplerHandle samplerSkybox;
+
+        // optional ARB_bindless_texture path, slots in the order of shaders/TextureTable.glsl
+        enum class TextureSlot {
+            DispY, DispX, DispZ, NormalMap, Perlin, FresnelLUT, Skybox, Foam0, Foam1, Wake0, Wake1, Count };
+        bool bindless;
+        std::unique_ptr<Core::BindlessTextureTable> textureTable; // declared after the textures, released first
+
+        // reduced FFT resolutions of the adaptive controller, the full resolution uses the members above
+        struct FFTPlan {
+            Core::TextureHandle texButterfly;
+            Core::BufferHandle ssboBitReversed;
+            std::unique_ptr<Core::ShaderProgram> amplitude;
+            std::unique_ptr<Core::ShaderProgram> butterfly;
+            WorkGroupTuner::Programs inverseFFT;
+            bool butterflyReady = false;
+        };
+        std::map<int, FFTPlan> fftPlans;
+        ResolutionController resolutionController;
+        bool adaptiveResolution;
+        float pixelsPerWave; // a wave has to span this many pixels to be simulated
+        int fixedResolution; // level while the controller is off
+        float visibleWave; // estimate of the last frame, for the GUI
+
+        // ssbo
+        Core::BufferHandle ssboBitReversed;
+        Core::BufferHandle ssboHeightRange;
+
+        // skybox faces decoded on worker threads, uploaded one per frame through pboSkybox
+        std::array<std::future<Core::PngImage>, 6> skyboxFaces;
+        std::array<bool, 6> skyboxFaceFailed; // filled with SKYBOX_FALLBACK_COLOR once the face size is known
+        int skyboxFacesPending;
+        int skyboxFaceSize;
+        Core::BufferHandle pboSkybox;
 
         // Ocean Surface variables
         float phillipsConst;
@@ -121,10 +237,101 @@ namespace OGL4Core2::Plugins::PCVC::OceanSurface {
         int butterflyStages;
         float choppiness;
         float suppression;
+        int seed;
         bool showWireframe;
         float waveHeight;
         float lightLong; 
         float lightLat;  
+        int shadingMode; // 0: Fresnel LUT, 1: analytic Fresnel, 2: difference of both
+        Spectrum spectrum;
+        SpectrumCache spectrumCache;
+        bool guiItemActive; // a GUI item is being dragged, spectrum updates are debounced
+        double lastSpectrumEdit;
+
+        // whitecaps from the Jacobian of the choppy displacement, accumulated over frames
+        int foamIndex; // texFoam[foamIndex] holds the current foam
+        float foamThreshold;
+        float foamDecay;
+        float foamStrength;
+        float foamTime; // simulation time of the last normal pass
+
+        // Periodic ocean and baked loop playback
+        bool loopEnabled;
+        float loopPeriod;
+        int loopFrames;
+        std::string loopCachePath;
+        std::string loopStatus;
+        bool playBaked;
+        std::unique_ptr<DisplacementCache> loopCache;
+
+        // Tileable Perlin noise, breaks up the repetition of the FFT patch in the distance
+        float perlinFrequency; // lattice cells across the patch in the first octave
+        int perlinOctaves;
+        float perlinPersistence;
+        float noiseStrength;
+        float noiseBlendStart; // camera distance where the noise starts to fade in
+        float noiseBlendEnd;
+        std::string perlinStatus;
+        std::string rngStatus;
+
+        // batched height queries, the GUI probe is one consumer
+        OceanQuery oceanQuery;
+        glm::vec2 probePoint;
+        OceanQuery::Ticket probeTicket;
+        OceanQuery::Result probeResult;
+        bool probeValid;
+
+        // optional CPU copy of the displacement for queries without GPU latency
+        std::unique_ptr<DisplacementMirror> mirror;
+        int mirrorInterval; // frames between readbacks
+        int mirrorDownsample;
+        std::string mirrorStatus;
+
+        // floating boxes, simulated and drawn on the GPU
+        std::unique_ptr<BuoyancySystem> bodies;
+        bool bodiesEnabled;
+        int bodyCount;
+        float bodySize; // edge length of the largest box
+        float bodyDensity; // relative to the water
+        BuoyancySystem::Params bodyParams;
+        double lastBodyTime;
+
+        // views of the one simulation, view 0 is the orbit camera, the others orbit a fixed target
+        struct ExtraView {
+            glm::vec4 rect; // x, y, width, height as fractions of the window
+            glm::vec3 target;
+            float yaw; // degrees
+            float pitch;
+            float distance;
+        };
+        ViewSet viewSet;
+        bool viewInstancing; // the surface of a batch of views is one instanced draw
+        glm::vec4 mainViewRect;
+        std::vector<ExtraView> extraViews;
+
+        // the scene is drawn offscreen at a scale that follows its GPU time, then sharpened into the window
+        RenderScale renderScale;
+        bool renderScaleEnabled;
+        RenderScale::Params renderScaleParams;
+
+        // spray particles from breaking crests, the live count stays on the GPU
+        std::unique_ptr<SpraySystem> spray;
+        bool sprayEnabled;
+        SpraySystem::Params sprayParams;
+        float sprayPointSize; // world units
+        double lastSprayTime;
+
+        // local wake regions, region 0 follows the camera and region 1 the moving source
+        bool wakeEnabled;
+        int wakeRegions;
+        float wakeSize; // world extent of a region
+        WakeSolver::Params wakeParams;
+        std::array<glm::vec2, 4> wakeCenters; // regions from 2 on stay where they are put
+        bool wakeBoat;
+        float wakeBoatSpeed;
+        float wakeBoatRadius;
+        bool wakePoke; // one splash at the probe point in the next frame
+        double lastWakeTime;
         
     };
 } // namespace OGL4Core2::Plugins::PCVC::OceanSurface
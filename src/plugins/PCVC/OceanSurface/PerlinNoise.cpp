@@ -0,0 +1,193 @@
+#include "PerlinNoise.h"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PERLIN_SSE2 1 // part of every x86-64 CPU, no runtime check needed
+#endif
+
+using namespace OGL4Core2::Plugins::PCVC::OceanSurface;
+
+/*
+ * 4-wide float vectors with the GLSL semantics used by PerlinNoise.comp, one with SSE2 and a plain one as reference.
+ * The operations are written exactly like the GLSL built-ins (e.g. mod(x, y) = x - y * floor(x / y)) so both sides
+ * round the same way.
+ */
+namespace {
+struct Scalar4 {
+    float f[4];
+
+    explicit Scalar4(float s) : f{s, s, s, s} {}
+    Scalar4(float x, float y, float z, float w) : f{x, y, z, w} {}
+
+    float operator[](int i) const {
+        return f[i];
+    }
+};
+
+#ifdef PERLIN_SSE2
+struct Sse4 {
+    __m128 v;
+
+    explicit Sse4(__m128 v) : v(v) {}
+    explicit Sse4(float s) : v(_mm_set1_ps(s)) {}
+    Sse4(float x, float y, float z, float w) : v(_mm_setr_ps(x, y, z, w)) {}
+
+    float operator[](int i) const {
+        alignas(16) float f[4];
+        _mm_store_ps(f, v);
+        return f[i];
+    }
+};
+#endif
+} // namespace
+
+static inline Scalar4 operator+(Scalar4 a, Scalar4 b) {
+    return {a.f[0] + b.f[0], a.f[1] + b.f[1], a.f[2] + b.f[2], a.f[3] + b.f[3]};
+}
+static inline Scalar4 operator-(Scalar4 a, Scalar4 b) {
+    return {a.f[0] - b.f[0], a.f[1] - b.f[1], a.f[2] - b.f[2], a.f[3] - b.f[3]};
+}
+static inline Scalar4 operator*(Scalar4 a, Scalar4 b) {
+    return {a.f[0] * b.f[0], a.f[1] * b.f[1], a.f[2] * b.f[2], a.f[3] * b.f[3]};
+}
+static inline Scalar4 operator/(Scalar4 a, Scalar4 b) {
+    return {a.f[0] / b.f[0], a.f[1] / b.f[1], a.f[2] / b.f[2], a.f[3] / b.f[3]};
+}
+static inline Scalar4 floor(Scalar4 a) {
+    return {std::floor(a.f[0]), std::floor(a.f[1]), std::floor(a.f[2]), std::floor(a.f[3])};
+}
+static inline Scalar4 abs(Scalar4 a) {
+    return {std::fabs(a.f[0]), std::fabs(a.f[1]), std::fabs(a.f[2]), std::fabs(a.f[3])};
+}
+
+#ifdef PERLIN_SSE2
+static inline Sse4 operator+(Sse4 a, Sse4 b) {
+    return Sse4(_mm_add_ps(a.v, b.v));
+}
+static inline Sse4 operator-(Sse4 a, Sse4 b) {
+    return Sse4(_mm_sub_ps(a.v, b.v));
+}
+static inline Sse4 operator*(Sse4 a, Sse4 b) {
+    return Sse4(_mm_mul_ps(a.v, b.v));
+}
+static inline Sse4 operator/(Sse4 a, Sse4 b) {
+    return Sse4(_mm_div_ps(a.v, b.v));
+}
+// SSE2 has no floor: truncate and step down where that rounded up, exact below 2^31 like the lattice coordinates
+static inline Sse4 floor(Sse4 a) {
+    const __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+    return Sse4(_mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a.v), _mm_set1_ps(1.0f))));
+}
+static inline Sse4 abs(Sse4 a) {
+    return Sse4(_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v));
+}
+#endif
+
+template <typename float4>
+static inline float4 fract(float4 a) {
+    return a - floor(a);
+}
+template <typename float4>
+static inline float4 mod(float4 x, float y) {
+    const float4 yy(y);
+    return x - yy * floor(x / yy);
+}
+template <typename float4>
+static inline float4 permute(float4 x) {
+    return mod(((x * float4(34.0f)) + float4(1.0f)) * x, 289.0f);
+}
+
+static inline float smoothing(float t) {
+    return t * t * t * (t * (6.0f * t - 15.0f) + 10.0f);
+}
+static inline float mix(float a, float b, float t) {
+    return a * (1.0f - t) + b * t;
+}
+
+/*
+ * @brief Same lattice hash, gradients and interpolation as Perlin() in PerlinNoise.comp
+ */
+template <typename float4>
+static float perlinNoise(float x, float y, float period) {
+
+    const float4 P(x, y, x, y);
+    float4 Pi = floor(P) + float4(0.0f, 0.0f, 1.0f, 1.0f);
+    const float4 Pf = fract(P) - float4(0.0f, 0.0f, 1.0f, 1.0f);
+    Pi = mod(Pi, period); // periodic gradients make the noise tileable
+    Pi = mod(Pi, 289.0f);
+
+    // the four corners as lanes in the order 00, 10, 01, 11
+    const float4 ix(Pi[0], Pi[2], Pi[0], Pi[2]);
+    const float4 iy(Pi[1], Pi[1], Pi[3], Pi[3]);
+    const float4 fx(Pf[0], Pf[2], Pf[0], Pf[2]);
+    const float4 fy(Pf[1], Pf[1], Pf[3], Pf[3]);
+
+    const float4 i = permute(permute(ix) + iy);
+    float4 gx = float4(2.0f) * fract(i * float4(0.0243902439f)) - float4(1.0f);
+    const float4 gy = abs(gx) - float4(0.5f);
+    const float4 tx = floor(gx + float4(0.5f));
+    gx = gx - tx;
+
+    // every lane is scaled by the taylor inverse sqrt of its own length
+    const float4 norm = float4(1.79284291400159f) - float4(0.85373472095314f) * (gx * gx + gy * gy);
+    gx = gx * norm;
+    const float4 gyn = gy * norm;
+
+    const float4 n = gx * fx + gyn * fy;
+
+    const float interpX = smoothing(Pf[0]);
+    const float interpY = smoothing(Pf[1]);
+
+    const float nx0 = mix(n[0], n[1], interpX);
+    const float nx1 = mix(n[2], n[3], interpX);
+    return 2.8f * mix(nx0, nx1, interpY);
+}
+
+float PerlinNoise::perlin(float x, float y, float period, bool simd) {
+#ifdef PERLIN_SSE2
+    if (simd)
+        return perlinNoise<Sse4>(x, y, period);
+#else
+    (void)simd;
+#endif
+    return perlinNoise<Scalar4>(x, y, period);
+}
+
+bool PerlinNoise::simdSupported() {
+#ifdef PERLIN_SSE2
+    return true;
+#else
+    return false;
+#endif
+}
+
+void PerlinNoise::generate(int N, float frequency, int octaves, float persistence, std::vector<float>& field,
+    bool simd) {
+
+    field.resize(size_t(N) * size_t(N));
+
+    for (int y = 0; y < N; y++) {
+        for (int x = 0; x < N; x++) {
+            const float cx = float(x) / float(N);
+            const float cy = float(y) / float(N);
+
+            float result = 0.0f;
+            float amplitude = 1.0f;
+            float amplitudeSum = 0.0f;
+            float octaveFrequency = frequency;
+
+            for (int i = 0; i < octaves; i++) {
+                float p = perlin(cx * octaveFrequency, cy * octaveFrequency, octaveFrequency, simd);
+                p = (0.5f * p) + 0.5f;
+
+                result += p * amplitude;
+                amplitudeSum += amplitude;
+                octaveFrequency *= 2.0f;
+                amplitude *= persistence;
+            }
+            field[size_t(y) * size_t(N) + size_t(x)] = result / amplitudeSum;
+        }
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+
+namespace OGL4Core2::Plugins::PCVC::OceanSurface {
+
+    /*
+     * @brief CPU version of PerlinNoise.comp, produces the same tileable multi-octave noise for headless use
+     *
+     * The four lattice corners of a cell are evaluated as one 4-wide vector, like the vec4 code in the shader. On
+     * x86-64 the vector is SSE2, which every such CPU has; the plain float version stays available as reference.
+     */
+    class PerlinNoise {
+    public:
+        // periodic gradient noise in [-1, 1], the lattice repeats every period cells
+        static float perlin(float x, float y, float period, bool simd = true);
+
+        // N x N single channel field in [0, 1], row major
+        static void generate(int N, float frequency, int octaves, float persistence, std::vector<float>& field,
+            bool simd = true);
+        // the SSE2 vector is compiled in, otherwise simd falls back to the plain version
+        [[nodiscard]] static bool simdSupported();
+    };
+} // namespace OGL4Core2::Plugins::PCVC::OceanSurface
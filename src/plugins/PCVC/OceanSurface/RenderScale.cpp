@@ -0,0 +1,160 @@
+#include "RenderScale.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "core/util/GLStateCache.h"
+
+using namespace OGL4Core2;
+using namespace OGL4Core2::Plugins::PCVC::OceanSurface;
+
+namespace {
+    constexpr int adjustFrames = 8;      // frames between two scale changes, longer than the query latency
+    constexpr float scaleStep = 0.05f;   // small changes would only make the image swim
+    constexpr float maxIncrease = 0.1f;  // per change, shrinking is not limited
+    constexpr float timeSmoothing = 0.25f;
+    constexpr float lowestScale = 0.25f;
+} // namespace
+
+RenderScale::RenderScale()
+    : framebufferSize(0, 0),
+      currentScale(1.0f),
+      timeMs(0.0f),
+      framesSinceChange(0),
+      fbo(0),
+      queries{},
+      queryPending{},
+      queryScale{},
+      nextQuery(0),
+      timing(false),
+      vaEmpty(0) {
+
+    glCreateFramebuffers(1, &fbo);
+    glCreateQueries(GL_TIME_ELAPSED, queryCount, queries.data());
+    glCreateVertexArrays(1, &vaEmpty);
+}
+
+RenderScale::~RenderScale() {
+    glDeleteVertexArrays(1, &vaEmpty);
+    glDeleteQueries(queryCount, queries.data());
+    glDeleteFramebuffers(1, &fbo);
+}
+
+/*
+ * @brief Allocate color and depth target at the framebuffer size
+ */
+void RenderScale::resize(int width, int height) {
+
+    const glm::ivec2 size(std::max(width, 1), std::max(height, 1));
+    if (size == framebufferSize)
+        return;
+    framebufferSize = size;
+
+    texColor = Core::TextureHandle(GL_TEXTURE_2D, "RenderScale");
+    glTextureStorage2D(texColor, 1, GL_RGBA8, size.x, size.y);
+    glTextureParameteri(texColor, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(texColor, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(texColor, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(texColor, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    texColor.setBytes(size_t(size.x) * size_t(size.y) * 4);
+
+    texDepth = Core::TextureHandle(GL_TEXTURE_2D, "RenderScale");
+    glTextureStorage2D(texDepth, 1, GL_DEPTH_COMPONENT32F, size.x, size.y);
+    texDepth.setBytes(size_t(size.x) * size_t(size.y) * 4);
+
+    glNamedFramebufferTexture(fbo, GL_COLOR_ATTACHMENT0, texColor, 0);
+    glNamedFramebufferTexture(fbo, GL_DEPTH_ATTACHMENT, texDepth, 0);
+}
+
+glm::ivec2 RenderScale::size() const {
+    return glm::ivec2(std::max(1, int(float(framebufferSize.x) * currentScale + 0.5f)),
+        std::max(1, int(float(framebufferSize.y) * currentScale + 0.5f)));
+}
+
+/*
+ * @brief Read the finished timer queries, oldest first, without waiting for the others
+ */
+void RenderScale::collectQueries() {
+
+    for (int i = 0; i < queryCount; i++) {
+        const int q = (nextQuery + i) % queryCount;
+        if (!queryPending[q])
+            continue;
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(queries[q], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available != GL_TRUE)
+            continue;
+
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(queries[q], GL_QUERY_RESULT, &ns);
+        queryPending[q] = false;
+
+        // a frame measured before the last change is converted to the current pixel count
+        const float ratio = currentScale / queryScale[q];
+        const float ms = float(double(ns) / 1.0e6) * ratio * ratio;
+        timeMs = timeMs > 0.0f ? timeMs + timeSmoothing * (ms - timeMs) : ms;
+    }
+}
+
+void RenderScale::begin(const Params& params) {
+
+    collectQueries();
+
+    if (!params.dynamic) {
+        currentScale = std::clamp(params.fixedScale, lowestScale, 1.0f);
+    } else if (timeMs > 0.0f && ++framesSinceChange >= adjustFrames) {
+        float scale = currentScale * std::sqrt(params.budgetMs / timeMs);
+        scale = std::min(scale, currentScale + maxIncrease);
+        scale = std::round(scale / scaleStep) * scaleStep;
+        scale = std::clamp(scale, std::max(params.minScale, lowestScale), 1.0f);
+        if (scale != currentScale) {
+            currentScale = scale;
+            framesSinceChange = 0;
+        }
+    }
+
+    const glm::ivec2 viewport = size();
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, viewport.x, viewport.y);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // all queries still in flight, this frame is not measured
+    timing = !queryPending[nextQuery];
+    if (timing) {
+        queryScale[nextQuery] = currentScale;
+        glBeginQuery(GL_TIME_ELAPSED, queries[nextQuery]);
+    }
+}
+
+void RenderScale::end() {
+
+    if (timing) {
+        glEndQuery(GL_TIME_ELAPSED);
+        queryPending[nextQuery] = true;
+        nextQuery = (nextQuery + 1) % queryCount;
+        timing = false;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, framebufferSize.x, framebufferSize.y);
+}
+
+/*
+ * @brief Full screen triangle that samples the scaled scene
+ */
+void RenderScale::present(const Core::ShaderProgram& program, const Params& params) const {
+
+    program.use();
+    Core::GLStateCache::bindTextureUnit(0, texColor);
+    Core::GLStateCache::bindSampler(0, 0); // the texture filters bilinearly itself
+    program.setUniform("scene", 0);
+    program.setUniform("regionSize", glm::vec2(size()));
+    program.setUniform("textureSize", glm::vec2(framebufferSize));
+    program.setUniform("sharpness", params.sharpness);
+
+    Core::GLStateCache::polygonMode(GL_FILL);
+    Core::GLStateCache::depthTest(false);
+    glBindVertexArray(vaEmpty);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    Core::GLStateCache::depthTest(true);
+}
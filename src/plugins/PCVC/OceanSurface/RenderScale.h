@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "core/shader/ShaderProgram.h"
+#include "core/util/GLHandle.h"
+
+namespace OGL4Core2::Plugins::PCVC::OceanSurface {
+
+    /*
+     * @brief Renders the scene into an offscreen target at a fraction of the framebuffer and sharpens it back up
+     *
+     * The targets have the size of the framebuffer, a lower scale only shrinks the viewport, so changing the scale
+     * never reallocates. The scene pass is timed with GL_TIME_ELAPSED queries that are read a few frames later,
+     * the scale follows the smoothed time towards the budget. The fragment cost grows with the pixel count, so the
+     * scale is corrected by the square root of the time ratio. present() upsamples bilinearly into the default
+     * framebuffer with a contrast adaptive sharpening filter.
+     */
+    class RenderScale {
+    public:
+        struct Params {
+            bool dynamic;   // follow the budget, otherwise fixedScale is used
+            float fixedScale;
+            float budgetMs; // GPU time of the scene pass
+            float minScale;
+            float sharpness; // 0 plain bilinear, 1 strongest sharpening
+        };
+
+        RenderScale();
+        ~RenderScale();
+
+        RenderScale(const RenderScale&) = delete;
+        RenderScale& operator=(const RenderScale&) = delete;
+
+        // framebuffer size, the targets are reallocated when it changed
+        void resize(int width, int height);
+
+        // pick the scale of this frame, bind the offscreen target with the scaled viewport, clear it, start timing
+        void begin(const Params& params);
+        // stop timing, bind the default framebuffer with the full viewport
+        void end();
+
+        // upsample the last scene into the bound framebuffer, the program draws the window filling quad
+        void present(const Core::ShaderProgram& program, const Params& params) const;
+
+        [[nodiscard]] float scale() const {
+            return currentScale;
+        }
+        // viewport of the scene inside the targets
+        [[nodiscard]] glm::ivec2 size() const;
+        // smoothed GPU time of the scene pass, 0 until the first query returned
+        [[nodiscard]] float gpuTimeMs() const {
+            return timeMs;
+        }
+
+    private:
+        void collectQueries();
+
+        static constexpr int queryCount = 4; // frames the measurement may lag behind
+
+        glm::ivec2 framebufferSize;
+        float currentScale;
+        float timeMs;
+        int framesSinceChange;
+
+        GLuint fbo;
+        Core::TextureHandle texColor;
+        Core::TextureHandle texDepth;
+
+        std::array<GLuint, queryCount> queries;
+        std::array<bool, queryCount> queryPending;
+        std::array<float, queryCount> queryScale; // scale of the measured frame
+        int nextQuery;
+        bool timing; // a query was started in begin()
+
+        GLuint vaEmpty; // the vertex shader generates the triangle
+    };
+} // namespace OGL4Core2::Plugins::PCVC::OceanSurface
@@ -0,0 +1,69 @@
+#include "ResolutionController.h"
+
+#include <algorithm>
+
+using namespace OGL4Core2::Plugins::PCVC::OceanSurface;
+
+ResolutionController::ResolutionController(int maxResolution, int minResolution, int holdFrames, int fadeFrames)
+    : holdFrames(holdFrames),
+      fadeFrames(fadeFrames),
+      current(maxResolution),
+      previous(maxResolution),
+      fadeFrame(fadeFrames),
+      candidate(maxResolution),
+      candidateFrames(0) {
+
+    for (int n = maxResolution; n >= minResolution; n /= 2) {
+        resolutions.insert(resolutions.begin(), n);
+    }
+}
+
+float ResolutionController::visibleWavelength(float distance, float focalScale, float viewportHeight,
+    float pixelsPerWave) {
+
+    // world size of one pixel at the distance, the near plane spans 2 / focalScale per unit distance
+    const float pixel = 2.0f * distance / (focalScale * std::max(viewportHeight, 1.0f));
+    return pixelsPerWave * pixel;
+}
+
+void ResolutionController::update(float wavelength, float patchSize) {
+
+    if (fadeFrame < fadeFrames)
+        fadeFrame++;
+
+    // lowest level whose shortest wave 2L/n is not longer than the visible one
+    int wanted = resolutions.back();
+    for (int n : resolutions) {
+        if (2.0f * patchSize / float(n) <= wavelength) {
+            wanted = n;
+            break;
+        }
+    }
+
+    if (wanted == current) {
+        candidateFrames = 0;
+        return;
+    }
+    if (wanted != candidate) {
+        candidate = wanted;
+        candidateFrames = 0;
+    }
+    // a running fade finishes first, a new one would blend three levels
+    if (++candidateFrames >= holdFrames && fadeFrame >= fadeFrames)
+        request(candidate);
+}
+
+void ResolutionController::request(int resolution) {
+
+    if (resolution == current)
+        return;
+    previous = current;
+    current = resolution;
+    fadeFrame = 0;
+    candidate = resolution;
+    candidateFrames = 0;
+}
+
+float ResolutionController::fade() const {
+    return fadeFrames > 0 ? std::min(float(fadeFrame + 1) / float(fadeFrames), 1.0f) : 1.0f;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+
+namespace OGL4Core2::Plugins::PCVC::OceanSurface {
+
+    /*
+     * @brief Picks the FFT resolution from the smallest wave the camera can still resolve
+     *
+     * A level of resolution n over a patch of size L resolves waves down to 2L/n. The wave that still covers a few
+     * pixels gets longer the further the camera is from the water, so the controller selects the lowest level that
+     * resolves it. A new level has to be requested for a number of frames before it is taken, then the old and new
+     * level are cross-faded over a few frames to avoid pops. The controller only lowers the resolution below
+     * maxResolution, a level above it would need larger output textures than the simulation has.
+     */
+    class ResolutionController {
+    public:
+        // levels are maxResolution, maxResolution / 2, ... down to minResolution, all powers of two
+        ResolutionController(int maxResolution, int minResolution, int holdFrames, int fadeFrames);
+
+        // world size of the shortest wave that spans pixelsPerWave pixels at the given distance; focalScale is
+        // projMx[1][1], i.e. 1 / tan(fovY / 2)
+        [[nodiscard]] static float visibleWavelength(float distance, float focalScale, float viewportHeight,
+            float pixelsPerWave);
+
+        // advance one frame with the wavelength to resolve over a patch of patchSize world units
+        void update(float wavelength, float patchSize);
+        // switch to a fixed resolution, with a cross-fade
+        void request(int resolution);
+
+        [[nodiscard]] int resolution() const {
+            return current;
+        }
+        // the level that is faded out while fading()
+        [[nodiscard]] int previousResolution() const {
+            return previous;
+        }
+        // weight of resolution() against previousResolution(), 1 when no fade runs
+        [[nodiscard]] float fade() const;
+        [[nodiscard]] bool fading() const {
+            return fade() < 1.0f;
+        }
+        [[nodiscard]] const std::vector<int>& levels() const {
+            return resolutions;
+        }
+
+    private:
+        std::vector<int> resolutions; // ascending
+        int holdFrames;
+        int fadeFrames;
+
+        int current;
+        int previous;
+        int fadeFrame;
+        int candidate; // level requested by the estimate, taken after holdFrames
+        int candidateFrames;
+    };
+} // namespace OGL4Core2::Plugins::PCVC::OceanSurface
@@ -0,0 +1,85 @@
+#include "Spectrum.h"
+
+#include <cmath>
+
+#include <imgui.h>
+
+#include "core/util/ImGuiUtil.h"
+
+using namespace OGL4Core2;
+using namespace OGL4Core2::Plugins::PCVC::OceanSurface;
+
+Spectrum::Spectrum()
+    : specType(Type::Phillips),
+      spreading(Spreading::Cosine),
+      swell(false),
+      fetch(300.0f),
+      depth(30.0f),
+      gamma(3.3f),
+      swellAmount(0.5f),
+      swellSpeed(15.0f),
+      swellAngle(90.0f),
+      swellSharpness(20.0f) {}
+
+/*
+ * @brief Defines selecting the shader variant, inserted after the #version line
+ */
+Core::ShaderPreprocessor::Defines Spectrum::shaderDefines() const {
+    Core::ShaderPreprocessor::Defines defines;
+    defines.emplace_back("SPECTRUM_TYPE", std::to_string(static_cast<int>(specType)));
+    defines.emplace_back("SPREADING", std::to_string(static_cast<int>(spreading)));
+    if (swell)
+        defines.emplace_back("SWELL", "");
+    return defines;
+}
+
+void Spectrum::setUniforms(const Core::ShaderProgram& program) const {
+    program.setUniform("fetch", fetch * 1000.0f);
+    program.setUniform("depth", depth);
+    program.setUniform("gamma", gamma);
+    program.setUniform("swellAmount", swellAmount);
+    program.setUniform("swellSpeed", swellSpeed);
+    program.setUniform("swellDir", glm::vec2(cosf(glm::radians(swellAngle)), sinf(glm::radians(swellAngle))));
+    program.setUniform("swellSharpness", swellSharpness);
+}
+
+std::vector<float> Spectrum::parameters() const {
+    return {fetch, depth, gamma, swellAmount, swellSpeed, swellAngle, swellSharpness};
+}
+
+bool Spectrum::drawGUI(bool& variantChanged) {
+    bool changed = false;
+    variantChanged = false;
+
+    if (ImGui::TreeNode("Spectrum")) {
+        variantChanged |= Core::ImGuiUtil::EnumCombo<Type>("Type", specType,
+            {
+                {Type::Phillips, "Phillips"},
+                {Type::PiersonMoskowitz, "Pierson-Moskowitz"},
+                {Type::JONSWAP, "JONSWAP"},
+                {Type::TMA, "TMA"},
+            });
+        variantChanged |= Core::ImGuiUtil::EnumCombo<Spreading>("Spreading", spreading,
+            {
+                {Spreading::Cosine, "cos^2"},
+                {Spreading::Cos2s, "cos-2s"},
+                {Spreading::DonelanBanner, "Donelan-Banner"},
+            });
+        if (specType == Type::JONSWAP || specType == Type::TMA) {
+            changed |= ImGui::SliderFloat("Fetch [km]", &fetch, 1.0f, 1000.0f);
+            changed |= ImGui::SliderFloat("Peak Enhancement", &gamma, 1.0f, 7.0f);
+        }
+        if (specType == Type::TMA)
+            changed |= ImGui::SliderFloat("Depth [m]", &depth, 1.0f, 200.0f);
+
+        variantChanged |= ImGui::Checkbox("Swell", &swell);
+        if (swell) {
+            changed |= ImGui::SliderFloat("Swell Amount", &swellAmount, 0.0f, 2.0f);
+            changed |= ImGui::SliderFloat("Swell Wind Speed", &swellSpeed, 1.0f, 40.0f);
+            changed |= ImGui::SliderFloat("Swell Direction", &swellAngle, 0.0f, 360.0f);
+            changed |= ImGui::SliderFloat("Swell Sharpness", &swellSharpness, 1.0f, 100.0f);
+        }
+        ImGui::TreePop();
+    }
+    return changed || variantChanged;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "core/shader/ShaderPreprocessor.h"
+#include "core/shader/ShaderProgram.h"
+
+namespace OGL4Core2::Plugins::PCVC::OceanSurface {
+
+    /*
+     * @brief Parameters of the initial wave spectrum h0(k)
+     *
+     * The spectrum type, the directional spreading function and the swell component select a specialized variant of
+     * PhillipsSpectrum.comp through preprocessor defines, so no per-texel branching is needed. All other parameters
+     * are plain uniforms.
+     */
+    class Spectrum {
+    public:
+        enum class Type {
+            Phillips = 0,
+            PiersonMoskowitz = 1,
+            JONSWAP = 2,
+            TMA = 3, // JONSWAP with finite depth attenuation
+        };
+
+        enum class Spreading {
+            Cosine = 0, // cos^2, the original Phillips directional term
+            Cos2s = 1,  // cos-2s with the exponent of Mitsuyasu et al. 1975
+            DonelanBanner = 2,
+        };
+
+        Spectrum();
+
+        [[nodiscard]] Core::ShaderPreprocessor::Defines shaderDefines() const;
+        void setUniforms(const Core::ShaderProgram& program) const;
+        // all uniform parameters, identifies a computed spectrum together with the defines
+        [[nodiscard]] std::vector<float> parameters() const;
+
+        // returns true if any parameter changed, variantChanged is set if the shader needs to be recompiled
+        bool drawGUI(bool& variantChanged);
+
+        [[nodiscard]] Type type() const {
+            return specType;
+        }
+        // water depth for the dispersion relation, 0 means deep water
+        [[nodiscard]] float dispersionDepth() const {
+            return specType == Type::TMA ? depth : 0.0f;
+        }
+
+    private:
+        Type specType;
+        Spreading spreading;
+        bool swell;
+
+        float fetch; // distance over which the wind blows [km]
+        float depth; // water depth for TMA [m]
+        float gamma; // JONSWAP peak enhancement
+
+        float swellAmount;
+        float swellSpeed; // wind speed of the distant storm [m/s]
+        float swellAngle; // direction in degrees
+        float swellSharpness; // cos-2s exponent of the swell
+    };
+} // namespace OGL4Core2::Plugins::PCVC::OceanSurface
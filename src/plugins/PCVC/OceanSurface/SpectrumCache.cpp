@@ -0,0 +1,51 @@
+#include "SpectrumCache.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace OGL4Core2::Plugins::PCVC::OceanSurface;
+
+SpectrumCache::SpectrumCache(size_t budgetBytes) : budgetBytes(budgetBytes), used(0) {}
+
+SpectrumCache::~SpectrumCache() {
+    clear();
+}
+
+const SpectrumCache::Entry* SpectrumCache::find(const SpectrumCacheKey& key) {
+
+    auto it = std::find_if(entries.begin(), entries.end(), [&key](const Entry& e) { return e.key == key; });
+    if (it == entries.end())
+        return nullptr;
+
+    entries.splice(entries.begin(), entries, it);
+    return &entries.front();
+}
+
+const SpectrumCache::Entry* SpectrumCache::insert(const SpectrumCacheKey& key, Core::TextureHandle texH0k,
+    Core::TextureHandle texH0minusk, size_t bytes) {
+
+    entries.push_front({key, std::move(texH0k), std::move(texH0minusk), bytes});
+    used += bytes;
+    evict();
+    return &entries.front();
+}
+
+void SpectrumCache::clear() {
+    entries.clear();
+    used = 0;
+}
+
+void SpectrumCache::setBudget(size_t bytes) {
+    budgetBytes = bytes;
+    evict();
+}
+
+/*
+ * @brief Drop least recently used entries until the budget is met, keeps at least the current entry
+ */
+void SpectrumCache::evict() {
+    while (used > budgetBytes && entries.size() > 1) {
+        used -= entries.back().bytes;
+        entries.pop_back();
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <string>
+#include <vector>
+
+#include <glad/gl.h>
+
+#include "core/util/GLHandle.h"
+
+namespace OGL4Core2::Plugins::PCVC::OceanSurface {
+
+    /*
+     * @brief Everything the initial spectrum h0(k) depends on
+     */
+    struct SpectrumCacheKey {
+        std::string variant;       // shader defines of the spectrum type
+        std::vector<float> values; // wind, amplitude, suppression and spectrum parameters
+        int seed;
+        int resolution;
+        float patchLength;
+
+        bool operator==(const SpectrumCacheKey& other) const {
+            return variant == other.variant && values == other.values && seed == other.seed &&
+                   resolution == other.resolution && patchLength == other.patchLength;
+        }
+    };
+
+    /*
+     * @brief Least recently used cache of initial spectrum textures, bounded by GPU memory
+     *
+     * The cache owns the textures. The most recently used entry is never evicted, so the textures returned by the
+     * last find() or insert() stay valid until the next call.
+     */
+    class SpectrumCache {
+    public:
+        struct Entry {
+            SpectrumCacheKey key;
+            Core::TextureHandle texH0k;
+            Core::TextureHandle texH0minusk;
+            size_t bytes;
+        };
+
+        explicit SpectrumCache(size_t budgetBytes);
+        ~SpectrumCache();
+
+        SpectrumCache(const SpectrumCache&) = delete;
+        SpectrumCache& operator=(const SpectrumCache&) = delete;
+
+        // returns nullptr on a miss, a hit becomes the most recently used entry
+        const Entry* find(const SpectrumCacheKey& key);
+        // takes ownership of the textures, evicts least recently used entries beyond the budget
+        const Entry* insert(const SpectrumCacheKey& key, Core::TextureHandle texH0k, Core::TextureHandle texH0minusk,
+            size_t bytes);
+        void clear();
+
+        [[nodiscard]] size_t size() const {
+            return entries.size();
+        }
+        [[nodiscard]] size_t usedBytes() const {
+            return used;
+        }
+        [[nodiscard]] size_t budget() const {
+            return budgetBytes;
+        }
+        void setBudget(size_t bytes);
+
+    private:
+        void evict();
+
+        std::list<Entry> entries; // front is the most recently used
+        size_t budgetBytes;
+        size_t used;
+    };
+} // namespace OGL4Core2::Plugins::PCVC::OceanSurface
@@ -0,0 +1,119 @@
+#include "SpraySystem.h"
+
+#include <cstddef>
+
+#include "core/util/GLStateCache.h"
+
+using namespace OGL4Core2;
+using namespace OGL4Core2::Plugins::PCVC::OceanSurface;
+
+namespace {
+    // position with age, velocity with lifetime
+    constexpr std::size_t particleBytes = 8 * sizeof(float);
+
+    static_assert(offsetof(SpraySystem::State, drawCount) == 8, "State must match the std430 layout of Spray.comp");
+    static_assert(offsetof(SpraySystem::State, groupsX) == 24, "State must match the std430 layout of Spray.comp");
+} // namespace
+
+SpraySystem::SpraySystem(std::size_t capacity)
+    : particleCapacity(capacity),
+      current(0),
+      frame(0),
+      ssboParticles{Core::BufferHandle("Spray"), Core::BufferHandle("Spray")},
+      ssboState("Spray"),
+      vaEmpty(0) {
+
+    const auto bytes = GLsizeiptr(capacity * particleBytes);
+    for (Core::BufferHandle& buffer : ssboParticles) {
+        glNamedBufferStorage(buffer, bytes, nullptr, 0);
+        buffer.setBytes(size_t(bytes));
+    }
+    glNamedBufferStorage(ssboState, sizeof(State), nullptr, GL_DYNAMIC_STORAGE_BIT); // cleared by clear()
+    ssboState.setBytes(sizeof(State));
+    clear();
+
+    glCreateVertexArrays(1, &vaEmpty);
+}
+
+SpraySystem::~SpraySystem() {
+    glDeleteVertexArrays(1, &vaEmpty);
+}
+
+void SpraySystem::clear() {
+
+    const State empty{{0, 0}, 0, 1, 0, 0, 0, 1, 1};
+    glNamedBufferSubData(ssboState, 0, sizeof(State), &empty);
+    current = 0;
+}
+
+/*
+ * @brief Simulate the live particles, append the new ones and prepare the indirect arguments of the next frame
+ */
+void SpraySystem::update(const Programs& programs, const OceanQuery::Surface& surface, int resolution,
+    const Params& params, float dt, GLuint texDispX, GLuint texDispY, GLuint texDispZ, GLuint texNormalMap) {
+
+    const int next = 1 - current;
+    Core::GLStateCache::bindStorageBuffer(7, ssboState);
+    Core::GLStateCache::bindStorageBuffer(8, ssboParticles[current]);
+    Core::GLStateCache::bindStorageBuffer(9, ssboParticles[next]);
+
+    // survivors of the live buffer, as many work groups as the last FINALIZE wrote
+    const Core::ShaderProgram& simulate = programs.simulate;
+    simulate.use();
+    OceanQuery::bindSurface(simulate, surface, texDispX, texDispY, texDispZ, texNormalMap);
+    simulate.setUniform("src", current);
+    simulate.setUniform("capacity", unsigned(particleCapacity));
+    simulate.setUniform("dt", dt);
+    simulate.setUniform("gravity", params.gravity);
+    simulate.setUniform("drag", params.drag);
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, ssboState);
+    glDispatchComputeIndirect(GLintptr(offsetof(State, groupsX)));
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // new particles on breaking crests, appended behind the survivors
+    const Core::ShaderProgram& emit = programs.emit;
+    emit.use();
+    OceanQuery::bindSurface(emit, surface, texDispX, texDispY, texDispZ, texNormalMap);
+    emit.setUniform("src", current);
+    emit.setUniform("capacity", unsigned(particleCapacity));
+    emit.setUniform("seed", unsigned(frame++));
+    emit.setUniform("emitThreshold", params.emitThreshold);
+    emit.setUniform("emitProbability", params.emitProbability);
+    emit.setUniform("emitSpeed", params.emitSpeed);
+    emit.setUniform("lifetime", params.lifetime);
+    const glm::ivec3 size = emit.getWorkGroupSize();
+    glDispatchCompute(GLuint(resolution / size.x), GLuint(resolution / size.y), 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    const Core::ShaderProgram& finalize = programs.finalize;
+    finalize.use();
+    finalize.setUniform("src", current);
+    finalize.setUniform("capacity", unsigned(particleCapacity));
+    finalize.setUniform("simulateGroupSize", unsigned(simulate.getWorkGroupSize().x));
+    glDispatchCompute(1, 1, 1);
+    // the indirect calls and the vertex shader read what FINALIZE wrote
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+    current = next;
+}
+
+void SpraySystem::draw(const Core::ShaderProgram& program) const {
+
+    program.use();
+    Core::GLStateCache::bindStorageBuffer(8, ssboParticles[current]);
+    glBindVertexArray(vaEmpty);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, ssboState);
+
+    // translucent sprites, sorted by nothing, so they do not write depth
+    glEnable(GL_PROGRAM_POINT_SIZE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+    glDrawArraysIndirect(GL_POINTS, reinterpret_cast<const void*>(offsetof(State, drawCount)));
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+    glDisable(GL_PROGRAM_POINT_SIZE);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+}
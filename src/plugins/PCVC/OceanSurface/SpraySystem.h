@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "core/shader/ShaderProgram.h"
+#include "core/util/GLHandle.h"
+#include "OceanQuery.h"
+
+namespace OGL4Core2::Plugins::PCVC::OceanSurface {
+
+    /*
+     * @brief Spray particles thrown off breaking crests, emitted, simulated and drawn entirely on the GPU
+     *
+     * Two particle buffers are used in turns. Each frame the live particles of one buffer are simulated and the
+     * survivors compacted into the other one, a prefix sum per work group keeps it to one atomicAdd per group. New
+     * particles are appended where the Jacobian in the normal map alpha falls below the threshold. A single
+     * invocation then writes the live count into the indirect arguments, so the next simulation step is dispatched
+     * with glDispatchComputeIndirect and the particles are drawn with glDrawArraysIndirect. The CPU never learns
+     * the particle count.
+     */
+    class SpraySystem {
+    public:
+        // layout of the state SSBO, std430; the draw and dispatch commands are read by the indirect calls
+        struct State {
+            GLuint count[2];
+            GLuint drawCount;
+            GLuint drawInstances;
+            GLuint drawFirst;
+            GLuint drawBaseInstance;
+            GLuint groupsX;
+            GLuint groupsY;
+            GLuint groupsZ;
+        };
+
+        struct Params {
+            float emitThreshold;   // Jacobian below which crests emit
+            float emitProbability; // per texel and frame on a fully breaking crest
+            float emitSpeed;
+            float lifetime; // mean, seconds
+            float gravity;
+            float drag; // per second
+        };
+
+        // the three variants of Spray.comp
+        struct Programs {
+            const Core::ShaderProgram& emit;
+            const Core::ShaderProgram& simulate;
+            const Core::ShaderProgram& finalize;
+        };
+
+        // capacity is the largest number of live particles, both buffers are allocated up front
+        explicit SpraySystem(std::size_t capacity);
+        ~SpraySystem();
+
+        SpraySystem(const SpraySystem&) = delete;
+        SpraySystem& operator=(const SpraySystem&) = delete;
+
+        // one frame: simulate, emit from the surface texels, write the indirect arguments
+        void update(const Programs& programs, const OceanQuery::Surface& surface, int resolution, const Params& params,
+            float dt, GLuint texDispX, GLuint texDispY, GLuint texDispZ, GLuint texNormalMap);
+
+        // draw the live particles as points, the program is bound and has its camera uniforms
+        void draw(const Core::ShaderProgram& program) const;
+
+        // remove all particles
+        void clear();
+
+        [[nodiscard]] std::size_t capacity() const {
+            return particleCapacity;
+        }
+
+    private:
+        std::size_t particleCapacity;
+        int current; // buffer holding the live particles
+        uint32_t frame;
+
+        std::array<Core::BufferHandle, 2> ssboParticles;
+        Core::BufferHandle ssboState; // also the indirect draw and dispatch buffer
+        GLuint vaEmpty; // the vertex shader fetches from ssboParticles
+    };
+} // namespace OGL4Core2::Plugins::PCVC::OceanSurface
@@ -0,0 +1,86 @@
+#include "ViewSet.h"
+
+#include <algorithm>
+
+// clang-format off
+#include <glad/gl.h>
+#include <GLFW/glfw3.h>
+// clang-format on
+
+using namespace OGL4Core2;
+using namespace OGL4Core2::Plugins::PCVC::OceanSurface;
+
+static_assert(sizeof(ViewSet::View) == 56 * sizeof(float), "View must match the std140 layout of Views.glsl");
+
+namespace {
+    bool overlaps(const glm::vec4& a, const glm::vec4& b) {
+        return a.x < b.x + b.z && b.x < a.x + a.z && a.y < b.y + b.w && b.y < a.y + a.w;
+    }
+} // namespace
+
+ViewSet::ViewSet(std::size_t capacity) : viewCapacity(capacity), uboViews("Views") {
+
+    const auto bytes = GLsizeiptr(capacity * sizeof(View));
+    glNamedBufferStorage(uboViews, bytes, nullptr, GL_DYNAMIC_STORAGE_BIT); // rewritten every frame
+    uboViews.setBytes(size_t(bytes));
+}
+
+ViewSet::View ViewSet::makeView(const glm::mat4& viewMx, const glm::mat4& projMx, const glm::vec4& viewport) {
+
+    const glm::mat4 invViewMx = glm::inverse(viewMx);
+    return {viewMx, projMx, invViewMx, glm::vec4(glm::vec3(invViewMx[3]), 1.0f), viewport};
+}
+
+bool ViewSet::instancingSupported() {
+    return glfwExtensionSupported("GL_ARB_shader_viewport_layer_array") == GLFW_TRUE;
+}
+
+/*
+ * @brief Upload the views and split them into batches of views that do not overlap
+ */
+void ViewSet::upload(const std::vector<View>& views) {
+
+    viewList.assign(views.begin(), views.begin() + std::min(views.size(), viewCapacity));
+    batchList.clear();
+    for (int i = 0; i < int(viewList.size()); i++) {
+        bool newBatch = batchList.empty();
+        if (!newBatch) {
+            const Batch& batch = batchList.back();
+            for (int j = batch.first; j < batch.first + batch.count; j++) {
+                newBatch |= overlaps(viewList[i].viewport, viewList[j].viewport);
+            }
+        }
+        if (newBatch)
+            batchList.push_back({i, 0});
+        batchList.back().count++;
+    }
+
+    if (!viewList.empty())
+        glNamedBufferSubData(uboViews, 0, GLsizeiptr(viewList.size() * sizeof(View)), viewList.data());
+    glBindBufferBase(GL_UNIFORM_BUFFER, 0, uboViews);
+}
+
+void ViewSet::clear(const Batch& batch) const {
+
+    if (batch.first == 0)
+        return;
+    glEnable(GL_SCISSOR_TEST);
+    for (int i = batch.first; i < batch.first + batch.count; i++) {
+        const glm::vec4& r = viewList[i].viewport;
+        glScissor(GLint(r.x), GLint(r.y), GLsizei(r.z), GLsizei(r.w));
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+    glDisable(GL_SCISSOR_TEST);
+}
+
+void ViewSet::setViewports(const Batch& batch) const {
+    for (int i = 0; i < batch.count; i++) {
+        const glm::vec4& r = viewList[batch.first + i].viewport;
+        glViewportIndexedf(GLuint(i), r.x, r.y, r.z, r.w);
+    }
+}
+
+void ViewSet::setViewport(int view) const {
+    const glm::vec4& r = viewList[view].viewport;
+    glViewport(GLint(r.x), GLint(r.y), GLsizei(r.z), GLsizei(r.w));
+}
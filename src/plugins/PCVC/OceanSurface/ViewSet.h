@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "core/util/GLHandle.h"
+
+namespace OGL4Core2::Plugins::PCVC::OceanSurface {
+
+    /*
+     * @brief Cameras and viewports of all views of a frame, in one uniform buffer read by the draw shaders
+     *
+     * The simulation runs once per frame, every view only draws. The views are uploaded once and split into
+     * batches of consecutive views whose viewports do not overlap. With ARB_shader_viewport_layer_array the
+     * surface of a whole batch is one instanced draw, the vertex shader picks the view and its viewport from the
+     * instance; otherwise the passes are drawn view by view with the view index as uniform. An overlapping view,
+     * e.g. a picture-in-picture, starts a new batch, its rectangle is cleared before it is drawn.
+     */
+    class ViewSet {
+    public:
+        // one element of the Views block in Views.glsl, std140
+        struct View {
+            glm::mat4 viewMx;
+            glm::mat4 projMx;
+            glm::mat4 invViewMx;
+            glm::vec4 camPos;   // w unused
+            glm::vec4 viewport; // x, y, width, height in pixels of the render target
+        };
+
+        // views first to first + count - 1
+        struct Batch {
+            int first;
+            int count;
+        };
+
+        // capacity is the size of the Views array, MAX_VIEWS in the shaders
+        explicit ViewSet(std::size_t capacity);
+
+        static View makeView(const glm::mat4& viewMx, const glm::mat4& projMx, const glm::vec4& viewport);
+
+        // upload the views of this frame and bind the buffer, views beyond the capacity are dropped
+        void upload(const std::vector<View>& views);
+
+        // clear the rectangles of the batch, except for the first batch that starts on a cleared target
+        void clear(const Batch& batch) const;
+        // one viewport per view of the batch, gl_ViewportIndex is the instance
+        void setViewports(const Batch& batch) const;
+        // the viewport of a single view
+        void setViewport(int view) const;
+
+        [[nodiscard]] const std::vector<Batch>& batches() const {
+            return batchList;
+        }
+        [[nodiscard]] const View& view(int i) const {
+            return viewList[i];
+        }
+        [[nodiscard]] std::size_t size() const {
+            return viewList.size();
+        }
+
+        // the vertex shader can write gl_ViewportIndex, so a batch can be drawn instanced
+        [[nodiscard]] static bool instancingSupported();
+
+    private:
+        std::size_t viewCapacity;
+        std::vector<View> viewList;
+        std::vector<Batch> batchList;
+        Core::BufferHandle uboViews;
+    };
+} // namespace OGL4Core2::Plugins::PCVC::OceanSurface
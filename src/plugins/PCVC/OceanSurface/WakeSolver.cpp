@@ -0,0 +1,150 @@
+#include "WakeSolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "core/util/GLStateCache.h"
+
+using namespace OGL4Core2;
+using namespace OGL4Core2::Plugins::PCVC::OceanSurface;
+
+static_assert(sizeof(WakeSolver::Source) == 4 * sizeof(float), "Source must match the std430 layout of Wake.comp");
+
+/*
+ * @brief Allocate one layer per region in the state and source arrays and the source buffer
+ */
+WakeSolver::WakeSolver(int resolution, int maxRegions, std::size_t sourceCapacity)
+    : resolution(resolution),
+      capacity(sourceCapacity),
+      regions(size_t(maxRegions), Region{glm::ivec2(0), glm::ivec2(0), 1.0f, glm::vec4(0.0f, 0.0f, 1.0f, 0.0f)}),
+      activeRegions(0),
+      accumulator(0.0f),
+      current(0),
+      textures{Core::TextureHandle(GL_TEXTURE_2D_ARRAY, "Wake"), Core::TextureHandle(GL_TEXTURE_2D_ARRAY, "Wake")},
+      texSources(GL_TEXTURE_2D_ARRAY, "Wake"),
+      ssboSources("Wake") {
+
+    const size_t texels = size_t(resolution) * size_t(resolution) * size_t(maxRegions);
+    for (Core::TextureHandle& texture : textures) {
+        glTextureStorage3D(texture, 1, GL_RG32F, resolution, resolution, maxRegions);
+        texture.setBytes(texels * 2 * sizeof(float));
+    }
+    glTextureStorage3D(texSources, 1, GL_R32I, resolution, resolution, maxRegions);
+    texSources.setBytes(texels * sizeof(GLint));
+    clear();
+
+    // a 16 byte header with the count, then the sources
+    const auto bytes = GLsizeiptr(4 * sizeof(GLuint) + capacity * sizeof(Source));
+    glNamedBufferStorage(ssboSources, bytes, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    ssboSources.setBytes(size_t(bytes));
+    beginFrame({});
+}
+
+void WakeSolver::setRegion(int index, glm::vec2 center, float size) {
+
+    Region& region = regions.at(size_t(index));
+    const float texelSize = size / float(resolution);
+    const glm::ivec2 cell = glm::ivec2(glm::round(center / texelSize)) - glm::ivec2(resolution / 2);
+    if (size != region.size) {
+        // another texel size does not line up with the stored waves, shifting by the whole grid discards them
+        region = Region{cell, glm::ivec2(resolution), size, region.stored};
+        return;
+    }
+    region.shift += cell - region.cell;
+    region.cell = cell;
+}
+
+void WakeSolver::setRegionCount(int count) {
+    activeRegions = std::clamp(count, 0, int(regions.size()));
+}
+
+void WakeSolver::beginFrame(const std::vector<Source>& sources) {
+
+    const GLuint header[4] = {GLuint(std::min(sources.size(), capacity)), 0, 0, 0};
+    glNamedBufferSubData(ssboSources, 0, sizeof(header), header);
+    if (header[0] > 0)
+        glNamedBufferSubData(ssboSources, sizeof(header), GLsizeiptr(header[0] * sizeof(Source)), sources.data());
+}
+
+/*
+ * @brief Splat this frame's sources and run the fixed steps that fit into the elapsed time
+ */
+void WakeSolver::update(const Core::ShaderProgram& inject, const Core::ShaderProgram& stepProgram,
+    const Params& params, float dt) {
+
+    if (activeRegions == 0)
+        return;
+
+    const auto setRegions = [this](const Core::ShaderProgram& program) {
+        program.setUniform("regionCount", activeRegions);
+        program.setUniform("resolution", resolution);
+        for (int r = 0; r < activeRegions; r++) {
+            const std::string index = "[" + std::to_string(r) + "]";
+            program.setUniform(("regions" + index).c_str(), regionRect(regions[size_t(r)]));
+            program.setUniform(("shifts" + index).c_str(), regions[size_t(r)].shift);
+        }
+    };
+
+    // sources are accumulated until the next step, even in frames without one
+    inject.use();
+    setRegions(inject);
+    inject.setUniform("sourceCapacity", unsigned(capacity));
+    Core::GLStateCache::bindStorageBuffer(10, ssboSources);
+    Core::GLStateCache::bindImageTexture(2, texSources, 0, GL_TRUE, 0, GL_READ_WRITE, GL_R32I);
+    const glm::ivec3 injectSize = inject.getWorkGroupSize();
+    glDispatchCompute(GLuint((capacity + size_t(injectSize.x) - 1) / size_t(injectSize.x)), 1, 1);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+    accumulator += dt;
+    const int steps = std::min(int(std::floor(accumulator / step)), maxSteps);
+    accumulator = std::min(accumulator - float(steps) * step, step); // drop the time the solver fell behind
+
+    stepProgram.use();
+    stepProgram.setUniform("waveSpeed", params.waveSpeed);
+    stepProgram.setUniform("dt", step);
+    stepProgram.setUniform("damping", params.damping);
+    stepProgram.setUniform("border", resolution / 16);
+    const glm::ivec3 size = stepProgram.getWorkGroupSize();
+    for (int i = 0; i < steps; i++) {
+        setRegions(stepProgram);
+        Core::GLStateCache::bindImageTexture(0, textures[current], 0, GL_TRUE, 0, GL_READ_ONLY, GL_RG32F);
+        Core::GLStateCache::bindImageTexture(1, textures[1 - current], 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RG32F);
+        glDispatchCompute(GLuint((resolution + size.x - 1) / size.x), GLuint((resolution + size.y - 1) / size.y),
+            GLuint(activeRegions));
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+        current = 1 - current;
+
+        // the shift is applied once, the stored field follows the region from now on
+        for (Region& region : regions) {
+            region.shift = glm::ivec2(0);
+            region.stored = regionRect(region);
+        }
+    }
+}
+
+void WakeSolver::setUniforms(const Core::ShaderProgram& program) const {
+
+    program.setUniform("wakeRegionCount", activeRegions);
+    program.setUniform("wakeIndex", current);
+    for (int r = 0; r < activeRegions; r++) {
+        program.setUniform(("wakeRegions[" + std::to_string(r) + "]").c_str(), regions[size_t(r)].stored);
+    }
+}
+
+/*
+ * @brief World corner (x, z) and extent of a region, as the shaders expect it
+ */
+glm::vec4 WakeSolver::regionRect(const Region& region) const {
+    const float texelSize = region.size / float(resolution);
+    return glm::vec4(glm::vec2(region.cell) * texelSize, region.size, 0.0f);
+}
+
+void WakeSolver::clear() {
+
+    for (Core::TextureHandle& texture : textures) {
+        glClearTexImage(texture, 0, GL_RG, GL_FLOAT, nullptr);
+    }
+    glClearTexImage(texSources, 0, GL_RED_INTEGER, GL_INT, nullptr);
+    accumulator = 0.0f;
+}
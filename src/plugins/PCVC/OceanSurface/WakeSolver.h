@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "core/shader/ShaderProgram.h"
+#include "core/util/GLHandle.h"
+
+namespace OGL4Core2::Plugins::PCVC::OceanSurface {
+
+    /*
+     * @brief Local wake and ripple heightfields on top of the FFT ocean
+     *
+     * Every region is a small square grid that follows a target in whole texels, so the waves stay in place while
+     * the region moves. The regions are the layers of one texture array and are all advanced by a damped wave
+     * equation in Wake.comp, with a fixed time step independent of the frame rate. Sources live in a GPU buffer:
+     * the CPU writes its own at the start of a frame and compute passes like Buoyancy.comp append more before
+     * update() splats them into the grids. The surface shaders add the height in the vertex and the slope in the
+     * fragment shader through shaders/Wake.glsl.
+     */
+    class WakeSolver {
+    public:
+        // one source in world space, std430 vec4
+        struct Source {
+            glm::vec2 position; // x, z
+            float radius;
+            float strength; // height added in one step
+        };
+
+        struct Params {
+            float waveSpeed; // world units per second
+            float damping;   // fraction of the height lost per step
+        };
+
+        static constexpr float step = 1.0f / 60.0f; // fixed solver time step
+        static constexpr int maxSteps = 4;           // steps per frame before the solver falls behind
+
+        // resolution of every region, the number of regions and the largest number of sources per frame
+        WakeSolver(int resolution, int maxRegions, std::size_t sourceCapacity);
+
+        // place region index around center, size is its world extent; a region follows its center in whole texels
+        void setRegion(int index, glm::vec2 center, float size);
+        // regions [0, count) are simulated and drawn
+        void setRegionCount(int count);
+
+        // start of a frame: the CPU sources replace those of the last frame
+        void beginFrame(const std::vector<Source>& sources);
+
+        // advance all regions by the fixed steps that fit into dt
+        void update(const Core::ShaderProgram& inject, const Core::ShaderProgram& stepProgram, const Params& params,
+            float dt);
+
+        // uniforms of shaders/Wake.glsl, the regions where the last completed step left the stored fields
+        void setUniforms(const Core::ShaderProgram& program) const;
+
+        // remove all waves
+        void clear();
+
+        [[nodiscard]] GLuint texture() const {
+            return textures[current];
+        }
+        [[nodiscard]] GLuint texture(int index) const {
+            return textures[index];
+        }
+        [[nodiscard]] int index() const {
+            return current;
+        }
+        [[nodiscard]] GLuint sourceBuffer() const {
+            return ssboSources;
+        }
+        [[nodiscard]] std::size_t sourceCapacity() const {
+            return capacity;
+        }
+        [[nodiscard]] int regionCount() const {
+            return activeRegions;
+        }
+
+    private:
+        struct Region {
+            glm::ivec2 cell;  // texel of the region corner on the world grid
+            glm::ivec2 shift; // texels moved since the last step
+            float size;
+            glm::vec4 stored; // rect of the stored field, cell and size move it only with the next step
+        };
+
+        [[nodiscard]] glm::vec4 regionRect(const Region& region) const;
+
+        int resolution;
+        std::size_t capacity;
+        std::vector<Region> regions;
+        int activeRegions;
+        float accumulator; // simulated time that did not fill a step yet
+        int current;
+
+        std::array<Core::TextureHandle, 2> textures; // RG32F height and previous height, one layer per region
+        Core::TextureHandle texSources;              // R32I fixed point source accumulation
+        Core::BufferHandle ssboSources;
+    };
+} // namespace OGL4Core2::Plugins::PCVC::OceanSurface
@@ -0,0 +1,271 @@
+#include "WorkGroupTuner.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include <imgui.h>
+
+using namespace OGL4Core2;
+using namespace OGL4Core2::Plugins::PCVC::OceanSurface;
+
+#define TIMED_DISPATCHES 8 // dispatches per timer query, averages out the launch overhead
+
+WorkGroupTuner::WorkGroupTuner(Core::ShaderManager& shaderManager, std::filesystem::path profileDir,
+    std::string profileName, int resolution)
+    : shaderManager(shaderManager),
+      profileDir(std::move(profileDir)),
+      profileName(std::move(profileName)),
+      resolution(resolution),
+      active(false),
+      currentPass(0),
+      currentCandidate(0),
+      compiling(false),
+      query(0),
+      queryPending(false) {
+    const auto* name = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    renderer = name != nullptr ? name : "unknown";
+    glGenQueries(1, &query);
+}
+
+WorkGroupTuner::~WorkGroupTuner() {
+    cancelCandidate();
+    glDeleteQueries(1, &query);
+}
+
+/*
+ * @brief Drop the programs of the current candidate, including requests the ShaderManager still compiles
+ */
+void WorkGroupTuner::cancelCandidate() {
+    for (auto& program : candidatePrograms)
+        shaderManager.cancel(program);
+    candidatePrograms.clear();
+    compiling = false;
+}
+
+int WorkGroupTuner::addPass(const std::string& name, glm::ivec2 fallback, std::vector<glm::ivec2> candidates,
+    CompileFunc compile, DispatchFunc dispatch) {
+
+    std::vector<double> times(candidates.size(), -1.0);
+    passes.push_back({name, std::move(candidates), std::move(times), std::move(compile), std::move(dispatch),
+        fallback, false});
+    return static_cast<int>(passes.size()) - 1;
+}
+
+/*
+ * @brief Profile file of the current GPU, the name hashes GL_RENDERER and the file repeats it in its first line
+ */
+std::filesystem::path WorkGroupTuner::profilePath() const {
+    // FNV-1a
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (char c : renderer) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001B3ull;
+    }
+    std::ostringstream name;
+    name << profileName << "-" << std::hex << std::setw(16) << std::setfill('0') << hash << ".txt";
+    return profileDir / name.str();
+}
+
+bool WorkGroupTuner::loadProfile() {
+
+    std::ifstream file(profilePath());
+    std::string line;
+    if (!file || !std::getline(file, line) || line != "renderer " + renderer)
+        return false;
+
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string tag, name;
+        int res = 0;
+        glm::ivec2 size(0);
+        double ms = 0.0;
+        if (!(fields >> tag >> name >> res >> size.x >> size.y >> ms) || tag != "pass" || res != resolution)
+            continue;
+        for (auto& pass : passes) {
+            if (pass.name == name && size.x > 0 && size.y > 0) {
+                pass.size = size;
+                pass.tuned = true;
+            }
+        }
+    }
+
+    for (const auto& pass : passes) {
+        if (!pass.tuned)
+            return false;
+    }
+    status = "Loaded " + profilePath().filename().string();
+    return true;
+}
+
+void WorkGroupTuner::saveProfile() {
+
+    std::error_code ec;
+    std::filesystem::create_directories(profileDir, ec);
+    std::ofstream file(profilePath(), std::ios::trunc);
+    if (!file) {
+        status = "Cannot write " + profilePath().string();
+        std::cerr << status << std::endl;
+        return;
+    }
+
+    file << "renderer " << renderer << "\n";
+    for (const auto& pass : passes) {
+        double best = -1.0;
+        for (size_t i = 0; i < pass.candidates.size(); i++) {
+            if (pass.candidates[i] == pass.size)
+                best = pass.timesMs[i];
+        }
+        file << "pass " << pass.name << " " << resolution << " " << pass.size.x << " " << pass.size.y << " " << best
+             << "\n";
+    }
+    status = "Saved " + profilePath().filename().string();
+}
+
+void WorkGroupTuner::start() {
+
+    for (auto& pass : passes)
+        std::fill(pass.timesMs.begin(), pass.timesMs.end(), -1.0);
+    cancelCandidate();
+    queryPending = false;
+    currentPass = 0;
+    currentCandidate = 0;
+    active = !passes.empty();
+    status.clear();
+}
+
+void WorkGroupTuner::restartPass(int pass) {
+
+    if (!active || currentPass != size_t(pass))
+        return;
+    std::fill(passes[currentPass].timesMs.begin(), passes[currentPass].timesMs.end(), -1.0);
+    cancelCandidate();
+    queryPending = false;
+    currentCandidate = 0;
+}
+
+bool WorkGroupTuner::step() {
+
+    if (!active)
+        return false;
+
+    if (queryPending) {
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available != GL_TRUE)
+            return false;
+
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+        passes[currentPass].timesMs[currentCandidate] = double(ns) / 1.0e6 / TIMED_DISPATCHES;
+        queryPending = false;
+        candidatePrograms.clear();
+        currentCandidate++;
+    }
+
+    if (compiling) {
+        const bool waiting = std::any_of(candidatePrograms.begin(), candidatePrograms.end(),
+            [this](const auto& program) { return shaderManager.pending(program); });
+        if (waiting)
+            return false;
+        compiling = false;
+
+        const bool linked = std::all_of(candidatePrograms.begin(), candidatePrograms.end(),
+            [](const auto& program) { return program != nullptr; });
+        if (linked) {
+            // the first dispatch after a program switch can include driver work, only the following ones are timed
+            const Pass& pass = passes[currentPass];
+            pass.dispatch(candidatePrograms);
+            glBeginQuery(GL_TIME_ELAPSED, query);
+            for (int i = 0; i < TIMED_DISPATCHES; i++)
+                pass.dispatch(candidatePrograms);
+            glEndQuery(GL_TIME_ELAPSED);
+            queryPending = true;
+            return false;
+        }
+        // the ShaderManager printed the compile error
+        candidatePrograms.clear();
+        currentCandidate++;
+    }
+
+    GLint maxInvocations = 0;
+    glm::ivec2 maxSize(0);
+    glGetIntegerv(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS, &maxInvocations);
+    glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_SIZE, 0, &maxSize.x);
+    glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_SIZE, 1, &maxSize.y);
+
+    while (currentPass < passes.size()) {
+        Pass& pass = passes[currentPass];
+
+        if (currentCandidate >= pass.candidates.size()) {
+            // keep the fallback if no candidate could be measured
+            double best = -1.0;
+            for (size_t i = 0; i < pass.candidates.size(); i++) {
+                if (pass.timesMs[i] >= 0.0 && (best < 0.0 || pass.timesMs[i] < best)) {
+                    best = pass.timesMs[i];
+                    pass.size = pass.candidates[i];
+                    pass.tuned = true;
+                }
+            }
+            currentPass++;
+            currentCandidate = 0;
+            continue;
+        }
+
+        const glm::ivec2 size = pass.candidates[currentCandidate];
+        const bool supported = size.x <= maxSize.x && size.y <= maxSize.y && size.x * size.y <= maxInvocations &&
+                               resolution % size.x == 0 && resolution % size.y == 0;
+        if (!supported) {
+            currentCandidate++;
+            continue;
+        }
+
+        // timing starts in a later step, once the ShaderManager linked every program of the candidate
+        try {
+            pass.compile(size, candidatePrograms);
+        } catch (const std::exception& e) {
+            std::cerr << pass.name << " " << size.x << "x" << size.y << ": " << e.what() << std::endl;
+            cancelCandidate();
+            currentCandidate++;
+            continue;
+        }
+        compiling = true;
+        return false;
+    }
+
+    active = false;
+    saveProfile();
+    return true;
+}
+
+void WorkGroupTuner::drawGUI() {
+
+    if (!ImGui::TreeNode("Work Groups"))
+        return;
+
+    for (const auto& pass : passes) {
+        double ms = -1.0;
+        for (size_t i = 0; i < pass.candidates.size(); i++) {
+            if (pass.candidates[i] == pass.size)
+                ms = pass.timesMs[i];
+        }
+        if (ms >= 0.0)
+            ImGui::Text("%-16s %3d x %-3d %.3f ms", pass.name.c_str(), pass.size.x, pass.size.y, ms);
+        else
+            ImGui::Text("%-16s %3d x %-3d %s", pass.name.c_str(), pass.size.x, pass.size.y,
+                pass.tuned ? "(profile)" : "(default)");
+    }
+
+    if (active) {
+        const Pass& pass = passes[std::min(currentPass, passes.size() - 1)];
+        ImGui::Text("Tuning %s: %d / %d", pass.name.c_str(), int(currentCandidate) + 1, int(pass.candidates.size()));
+    } else if (ImGui::Button("Autotune")) {
+        start();
+    }
+    if (!status.empty())
+        ImGui::TextUnformatted(status.c_str());
+    ImGui::TreePop();
+}
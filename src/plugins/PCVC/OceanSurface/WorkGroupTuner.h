@@ -0,0 +1,95 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include "core/shader/ShaderManager.h"
+#include "core/shader/ShaderProgram.h"
+
+namespace OGL4Core2::Plugins::PCVC::OceanSurface {
+
+    /*
+     * @brief Picks the fastest local work group size of each compute pass with GL_TIME_ELAPSED queries
+     *
+     * Tuning runs alongside the normal rendering, one candidate at a time: the candidate is submitted to the
+     * ShaderManager, and once it is linked it is dispatched once to warm up and then timed over several dispatches.
+     * Neither the compile nor the query result is waited for, step() returns early until they are ready. The
+     * results are stored in a profile per GL_RENDERER and loaded on later runs.
+     */
+    class WorkGroupTuner {
+    public:
+        // all programs one pass needs for a work group size, e.g. the variants of the FFT
+        using Programs = std::vector<std::unique_ptr<Core::ShaderProgram>>;
+        // submits the programs for a work group size to the ShaderManager, into the given (empty) list
+        using CompileFunc = std::function<void(glm::ivec2 size, Programs& programs)>;
+        // runs the pass with the given programs, must not change the result of the simulation
+        using DispatchFunc = std::function<void(const Programs& programs)>;
+
+        struct Pass {
+            std::string name;
+            std::vector<glm::ivec2> candidates;
+            std::vector<double> timesMs; // per candidate, negative if not measured or failed
+            CompileFunc compile;
+            DispatchFunc dispatch;
+            glm::ivec2 size; // tuned size, the fallback until tuned
+            bool tuned;
+        };
+
+        WorkGroupTuner(Core::ShaderManager& shaderManager, std::filesystem::path profileDir, std::string profileName,
+            int resolution);
+        ~WorkGroupTuner();
+
+        WorkGroupTuner(const WorkGroupTuner&) = delete;
+        WorkGroupTuner& operator=(const WorkGroupTuner&) = delete;
+
+        // returns the id of the pass, fallback is used until the pass is tuned
+        int addPass(const std::string& name, glm::ivec2 fallback, std::vector<glm::ivec2> candidates,
+            CompileFunc compile, DispatchFunc dispatch);
+
+        [[nodiscard]] glm::ivec2 size(int pass) const {
+            return passes[pass].size;
+        }
+        [[nodiscard]] bool running() const {
+            return active;
+        }
+
+        // load the profile of the current GPU, true if it has a size for every pass
+        bool loadProfile();
+        // benchmark all passes again, candidates the GPU does not support are skipped
+        void start();
+        // measure the candidates of a pass again if it is being tuned, e.g. after its shader variant changed
+        void restartPass(int pass);
+        // advance tuning by one candidate, returns true once all passes are tuned and the profile is saved
+        bool step();
+
+        void drawGUI();
+
+    private:
+        [[nodiscard]] std::filesystem::path profilePath() const;
+        void saveProfile();
+        void cancelCandidate();
+
+        Core::ShaderManager& shaderManager;
+        std::filesystem::path profileDir;
+        std::string profileName;
+        std::string renderer;
+        int resolution;
+        std::vector<Pass> passes;
+        std::string status;
+
+        // tuning state
+        bool active;
+        size_t currentPass;
+        size_t currentCandidate;
+        Programs candidatePrograms;
+        bool compiling; // candidatePrograms are submitted but not all finished
+        GLuint query;
+        bool queryPending;
+    };
+} // namespace OGL4Core2::Plugins::PCVC::OceanSurface
@@ -0,0 +1,19 @@
+#version 430
+
+layout(location = 0) out vec4 fragColor;
+
+in vec3 normal;
+flat in int instance;
+
+uniform vec3 lightDir; // directional light
+
+void main(){
+
+    // a few buoy and debris colors, picked per body
+    const vec3 colors[4] = vec3[](vec3(0.9, 0.35, 0.1), vec3(0.95, 0.85, 0.2), vec3(0.45, 0.3, 0.2),
+        vec3(0.8, 0.8, 0.75));
+    vec3 albedo = colors[instance % 4];
+
+    float diffuse = max(dot(normalize(normal), lightDir), 0.0);
+    fragColor = vec4(albedo * (0.25 + 0.75 * diffuse), 1.0);
+}
@@ -0,0 +1,22 @@
+#version 430
+
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec3 in_normal;
+
+// model matrices written by Buoyancy.comp
+layout(std430, binding = 6) readonly buffer bodyInstances{
+    mat4 instances[];
+};
+
+#include "Views.glsl"
+
+out vec3 normal;
+flat out int instance;
+
+void main(){
+
+    mat4 modelMx = instances[gl_InstanceID];
+    normal = normalize(mat3(transpose(inverse(modelMx))) * in_normal);
+    instance = gl_InstanceID;
+    gl_Position = views[viewIndex].projMx * views[viewIndex].viewMx * modelMx * vec4(in_position, 1.0);
+}
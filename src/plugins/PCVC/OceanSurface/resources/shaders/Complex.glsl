@@ -0,0 +1,34 @@
+/*
+    Complex numbers for the FFT shaders, stored as real and imaginary part
+    Included with #include "Complex.glsl", the include is resolved on the CPU side
+*/
+
+struct complex{
+    float real;
+    float im;
+};
+
+// add two complex
+complex add(complex c0, complex c1){
+
+    complex c;
+    c.real = c0.real + c1.real;
+    c.im = c0.im + c1.im;
+    return c;
+}
+
+// multiply two complex
+complex mul(complex c0, complex c1){
+
+    complex c;
+    c.real = c0.real * c1.real - c0.im * c1.im;
+    c.im  = c0.real * c1.im + c0.im * c1.real;
+    return c;
+}
+
+// conjugate the complex 
+complex conj(complex c){
+
+    complex c_conj = complex(c.real, -c.im);
+    return c_conj;
+}
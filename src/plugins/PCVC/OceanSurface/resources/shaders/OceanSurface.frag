@@ -1,5 +1,9 @@
 #version 430
 
+#include "TextureTable.glsl"
+#include "Wake.glsl"
+#include "Views.glsl"
+
 layout(location = 0) out vec4 fragColor;
 
 layout(std430, binding = 1) buffer data{
@@ -8,11 +12,22 @@ layout(std430, binding = 1) buffer data{
 
 in vec3 worldPos;
 in vec3 normal;
-
+in vec2 texCoords;
+flat in int viewId;
+
+#ifdef BINDLESS
+#define skybox TABLE_SAMPLERCUBE(TEX_SKYBOX)
+#define fresnelLUT TABLE_SAMPLER2D(TEX_FRESNEL_LUT)
+uniform int foamIndex;
+#define foam TABLE_SAMPLER2D(TEX_FOAM_0 + foamIndex)
+#else
 uniform samplerCube skybox;
+uniform sampler2D fresnelLUT; // fresnelFull() over (N.V in [-1,1], |N.L| in [0,1])
+uniform sampler2D foam; // whitecap coverage accumulated by NormalMap.comp
+#endif
+uniform float foamStrength;
+uniform int shadingMode; // 0: LUT, 1: analytic, 2: difference of both
 
-uniform mat4 invViewMx;
-uniform vec3 camPos;
 uniform vec3 lightDir; // directional light
 
 // each vertex, I = I_amb + I_diff + I_spec + I_refl + I_refrac
@@ -39,14 +54,6 @@ vec3 refraction(vec3 I, vec3 N){ // same as built-in function
     else return vec3(eta*I + (eta * cosi - sqrt(k)) * N);
 }
 
-//fresnel equation from the paper Synthesis of Ocean Wave Models and Simulation Using GPU, D.Lee and S.Lee
-float fresnel(vec3 N, vec3 V, float F0){
-
-    float cosTheta = max(dot(N, V), -dot(N,V));
-    return F0 + (1.0 - F0) * pow(1.0 - cosTheta, 5.0);
-}
-
-
 // water is both reflective and refractive, so the amount is computed with Fresnel equations
 // returns the amount of reflection, so the amount of refraction can be achieved by 1 - return value
 float fresnelFull(float thethaI, float thethaT){
@@ -72,22 +79,32 @@ void main() {
     float relativeH = clamp((worldPos.y - maxMin[1]) / (maxMin[0] - maxMin[1]), 0.0, 1.0);
     vec3 oceanColor = (relativeH*shallowOcean) + ((1.0-relativeH)*deepOcean);
 
-    vec3 N = normalize(normal);
-    vec3 V = normalize(camPos - worldPos); // view direction (direction to camera)
+    // the wake is finer than the grid, its slope is added per fragment
+    vec2 wakeSlope = wakeGradient(worldPos.xz);
+    vec3 N = normalize(normalize(normal) - vec3(wakeSlope.x, 0.0, wakeSlope.y));
+    vec3 V = normalize(views[viewId].camPos.xyz - worldPos); // view direction (direction to camera)
     vec3 I = -V; // reverse of view dir is the incident ray dir
     vec3 R = reflect(-V, N); 
     // global reflection is achieved by using the reflection vector as the texture coordinate to skybox texture
     vec3 sky = texture(skybox, R).rgb;
-   
-    // fresnel test1
-    float F = fresnel(N, V, 0.6);
-    vec3 albedo = mix(sky, oceanColor, F);
-    //vec3 color = max(dot(N, lightDir), 0.0) * albedo;
-
-    // fresnel test2
-    vec3 refracted = refract(-lightDir,N, 1.0/1.33);
-    float fresnelfull =  fresnelFull(dot(N, V), dot(-N,refracted));
+
+    // baked reflectance, same as the analytic path below
+    float fresnelfull = texture(fresnelLUT, vec2(0.5 * dot(N, V) + 0.5, abs(dot(N, lightDir)))).r;
+
+    if (shadingMode != 0) {
+        vec3 refracted = refract(-lightDir,N, 1.0/1.33);
+        float analytic = fresnelFull(dot(N, V), dot(-N,refracted));
+        fresnelfull = shadingMode == 1 ? analytic : 100.0 * abs(fresnelfull - analytic);
+    }
     vec3 color = mix(sky, oceanColor, 1.0-fresnelfull); // sky * fresnell + oceanColor *(1-fresnellfull)
+
+    // whitecaps are lit diffusely, they hide the reflection underneath
+    float whitecap = foamStrength * texture(foam, texCoords).r;
+    vec3 foamColor = vec3(0.9) * (0.4 + 0.6 * max(dot(N, lightDir), 0.0));
+    color = mix(color, foamColor, clamp(whitecap, 0.0, 1.0));
+
+    if (shadingMode == 2)
+        color = vec3(fresnelfull);
     
     /* additional lighting settings but commented out */
     // HDR tonemapping to transform points to range [0,1]
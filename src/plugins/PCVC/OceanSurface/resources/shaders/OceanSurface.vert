@@ -1,38 +1,75 @@
 #version 430
+#ifdef VIEW_INSTANCING
+#extension GL_ARB_shader_viewport_layer_array : require
+#endif
+
+#include "TextureTable.glsl"
+#include "Wake.glsl"
+#include "Views.glsl"
 
-uniform mat4 projMx;
-uniform mat4 viewMx;
 uniform mat4 modelMx;
 
 layout(location = 0) in vec3 in_position;
 layout(location = 1) in vec2 in_texCoords;
 
+#ifdef BINDLESS
+#define dispX TABLE_SAMPLER2D(TEX_DISP_X)
+#define dispY TABLE_SAMPLER2D(TEX_DISP_Y)
+#define dispZ TABLE_SAMPLER2D(TEX_DISP_Z)
+#define normalMap TABLE_SAMPLER2D(TEX_NORMAL_MAP)
+#define perlinNoise TABLE_SAMPLER2D(TEX_PERLIN)
+#else
 uniform sampler2D dispX;
 uniform sampler2D dispY;
 uniform sampler2D dispZ;
 
 uniform sampler2D normalMap;
+uniform sampler2D perlinNoise; // tileable, same period as the FFT patch
+#endif
+
+uniform float noiseStrength;
+uniform float noiseBlendStart;
+uniform float noiseBlendEnd;
 
 uniform float choppiness;
 uniform float waveHeight;
 
 out vec3 worldPos;
 out vec3 normal;
+out vec2 texCoords;
+flat out int viewId;
 
 
 void main() {
 
-    float height = in_position.y + waveHeight * texture(dispY, in_texCoords).r;
-    float xPos = in_position.x - texture(dispX, in_texCoords).r * choppiness;
-    float zPos = in_position.z - texture(dispZ, in_texCoords).r * choppiness;
+#ifdef VIEW_INSTANCING
+    // one instance per view of the batch, each rasterized into its own viewport
+    viewId = viewIndex + gl_InstanceID;
+    gl_ViewportIndex = gl_InstanceID;
+#else
+    viewId = viewIndex;
+#endif
+    View view = views[viewId];
+
+    // modulate the wave amplitude with low frequency noise in the distance to hide the repetition of the patch
+    float camDist = distance(view.camPos.xyz, vec3(modelMx * vec4(in_position, 1.0)));
+    float noiseBlend = noiseStrength * smoothstep(noiseBlendStart, noiseBlendEnd, camDist);
+    float amplitude = mix(1.0, 2.0 * texture(perlinNoise, in_texCoords).r, noiseBlend);
+
+    float height = in_position.y + waveHeight * amplitude * texture(dispY, in_texCoords).r;
+    float xPos = in_position.x - texture(dispX, in_texCoords).r * choppiness * amplitude;
+    float zPos = in_position.z - texture(dispZ, in_texCoords).r * choppiness * amplitude;
 
     vec3 normalVec = texture(normalMap, in_texCoords).rgb;
 
     // apply model transform to normals (Local to World) but remove translate and apply only scale and rotation 
     normal = mat3(transpose(inverse(modelMx))) * normalVec;
+    texCoords = in_texCoords;
+    // the wake regions live in world space, the model matrix only translates the grid
+    height += wakeHeight(vec3(modelMx * vec4(xPos, height, zPos, 1.0)).xz);
     worldPos =  vec3(modelMx * vec4(xPos, height, zPos, 1.0));
    
-    gl_Position = projMx * viewMx * modelMx * vec4(xPos, height, zPos, 1.0);
+    gl_Position = view.projMx * view.viewMx * modelMx * vec4(xPos, height, zPos, 1.0);
 
     // geom shader version
     //texCoords= in_texCoords;
@@ -1,10 +1,16 @@
 #version 430
 
+#include "TextureTable.glsl"
+
 layout(location = 0) out vec4 fragColor;
 
 in vec3 texCoords;
 
+#ifdef BINDLESS
+#define skybox TABLE_SAMPLERCUBE(TEX_SKYBOX)
+#else
 uniform samplerCube skybox;
+#endif
 
 void main(){
 
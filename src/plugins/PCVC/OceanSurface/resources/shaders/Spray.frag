@@ -0,0 +1,15 @@
+#version 430
+
+layout(location = 0) out vec4 fragColor;
+
+in float fade;
+
+void main(){
+
+    // round sprites with a soft edge
+    vec2 p = 2.0 * gl_PointCoord - 1.0;
+    float r2 = dot(p, p);
+    if(r2 > 1.0) discard;
+
+    fragColor = vec4(vec3(0.95), 0.6 * fade * (1.0 - r2));
+}
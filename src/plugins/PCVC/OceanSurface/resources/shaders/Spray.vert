@@ -0,0 +1,29 @@
+#version 430
+
+struct Particle{
+    vec4 position; // xyz, age in w
+    vec4 velocity; // xyz, lifetime in w
+};
+
+// live particles of the current buffer, drawn with the count FINALIZE wrote to the indirect buffer
+layout(std430, binding = 8) readonly buffer sprayIn{
+    Particle particles[];
+};
+
+#include "Views.glsl"
+
+uniform float pointSize; // world units
+
+out float fade;
+
+void main(){
+
+    View view = views[viewIndex];
+    Particle p = particles[gl_VertexID];
+    fade = 1.0 - p.position.w / p.velocity.w;
+
+    vec4 viewPos = view.viewMx * vec4(p.position.xyz, 1.0);
+    gl_Position = view.projMx * viewPos;
+    // perspective size of a world space sprite, projMx[1][1] relates view space to half the viewport
+    gl_PointSize = clamp(pointSize * view.projMx[1][1] / -viewPos.z * 0.5 * view.viewport.w, 1.0, 32.0);
+}
@@ -0,0 +1,62 @@
+/*
+    Sampling of the displaced ocean surface at world space points, shared by the query and buoyancy passes
+    Included with #include "SurfaceSample.glsl", expects the displacement textures on image units 0-3
+    The choppy displacement moves surface points horizontally, so the texture coordinate whose displaced position
+    lands on (x, z) is found by fixed point iteration first. All lookups are bilinear and wrap, the FFT patch is
+    periodic.
+*/
+
+layout(binding = 0, rgba32f) readonly uniform image2D dispX;
+layout(binding = 1, rgba32f) readonly uniform image2D dispY;
+layout(binding = 2, rgba32f) readonly uniform image2D dispZ;
+layout(binding = 3, rgba32f) readonly uniform image2D normalMap;
+
+uniform vec2 origin; // world (x, z) of texel (0, 0)
+uniform float texelSize;
+uniform float choppiness;
+uniform float waveHeight;
+uniform int iterations;
+
+// corners and weights of a bilinear lookup at a texel position, wraps around the patch
+void bilinearSetup(vec2 texel, out ivec2 p0, out ivec2 p1, out vec2 f){
+
+    vec2 base = floor(texel);
+    f = texel - base;
+    p0 = ivec2(mod(base, float(N)));
+    p1 = ivec2(mod(base + 1.0, float(N)));
+}
+
+// images cannot be passed to functions with their format, so the lookup itself is a macro
+#define BILINEAR(img, p0, p1, f) mix(mix(imageLoad(img, p0), imageLoad(img, ivec2(p1.x, p0.y)), f.x), \
+                                     mix(imageLoad(img, ivec2(p0.x, p1.y)), imageLoad(img, p1), f.x), f.y)
+
+// horizontal displacement of the surface point at a texel position, as in OceanSurface.vert
+vec2 horizontalOffset(vec2 texel){
+
+    ivec2 p0, p1;
+    vec2 f;
+    bilinearSetup(texel, p0, p1, f);
+    return -choppiness * vec2(BILINEAR(dispX, p0, p1, f).r, BILINEAR(dispZ, p0, p1, f).r);
+}
+
+// displaced surface point above target, residual is the horizontal distance left after the inversion
+vec3 surfacePoint(vec2 target, out vec3 normal, out float residual){
+
+    vec2 undisplaced = target;
+
+    // find the undisplaced point p with p + offset(p) = target
+    for(int k = 0; k < iterations; k++){
+        vec2 texel = (undisplaced - origin) / texelSize;
+        undisplaced = target - horizontalOffset(texel);
+    }
+
+    vec2 texel = (undisplaced - origin) / texelSize;
+    vec2 surface = undisplaced + horizontalOffset(texel);
+
+    ivec2 p0, p1;
+    vec2 f;
+    bilinearSetup(texel, p0, p1, f);
+    normal = normalize(BILINEAR(normalMap, p0, p1, f).rgb);
+    residual = distance(surface, target);
+    return vec3(surface.x, waveHeight * BILINEAR(dispY, p0, p1, f).r, surface.y);
+}
@@ -0,0 +1,30 @@
+/*
+    Bindless texture handles of the ocean, compiled in with the BINDLESS define
+    Included with #include "TextureTable.glsl" directly after #version, the extension directive has to come first
+    The slots have the same order as OceanSurface::TextureSlot
+*/
+
+#define TEX_DISP_Y 0
+#define TEX_DISP_X 1
+#define TEX_DISP_Z 2
+#define TEX_NORMAL_MAP 3
+#define TEX_PERLIN 4
+#define TEX_FRESNEL_LUT 5
+#define TEX_SKYBOX 6
+#define TEX_FOAM_0 7 // foam ping-pong pair, the current one is TEX_FOAM_0 + foamIndex
+#define TEX_FOAM_1 8
+#define TEX_WAKE_0 9 // wake ping-pong pair, the current one is TEX_WAKE_0 + wakeIndex
+#define TEX_WAKE_1 10
+
+#ifdef BINDLESS
+#extension GL_ARB_bindless_texture : require
+
+// resident handles with their sampler state, written once by the CPU
+layout(std430, binding = 2) readonly buffer textureTable{
+    uvec2 textureHandles[];
+};
+
+#define TABLE_SAMPLER2D(slot) sampler2D(textureHandles[slot])
+#define TABLE_SAMPLERCUBE(slot) samplerCube(textureHandles[slot])
+#define TABLE_SAMPLER2DARRAY(slot) sampler2DArray(textureHandles[slot])
+#endif
@@ -0,0 +1,39 @@
+/*
+    Upsampling of the scene rendered at a lower resolution, bilinear with contrast adaptive sharpening
+    The scene occupies the lower left regionSize texels of the target, the rest of the target is stale
+*/
+#version 430
+
+layout(location = 0) out vec4 fragColor;
+
+in vec2 uv;
+
+uniform sampler2D scene;
+uniform vec2 regionSize; // texels rendered this frame
+uniform vec2 textureSize;
+uniform float sharpness; // 0 bilinear, 1 strongest
+
+vec3 fetch(vec2 texel){
+    // clamped half a texel inside the region, so the filter never reads the stale border
+    texel = clamp(texel, vec2(0.5), regionSize - 0.5);
+    return texture(scene, texel / textureSize).rgb;
+}
+
+void main(){
+
+    vec2 texel = uv * regionSize;
+    vec3 c = fetch(texel);
+    vec3 n = fetch(texel + vec2(0.0, 1.0));
+    vec3 s = fetch(texel - vec2(0.0, 1.0));
+    vec3 e = fetch(texel + vec2(1.0, 0.0));
+    vec3 w = fetch(texel - vec2(1.0, 0.0));
+
+    // the sharpening weight falls off where the neighbourhood already has high contrast, avoids ringing
+    vec3 mn = min(c, min(min(n, s), min(e, w)));
+    vec3 mx = max(c, max(max(n, s), max(e, w)));
+    vec3 amp = sqrt(clamp(min(mn, 1.0 - mx) / max(mx, 1e-5), 0.0, 1.0));
+    vec3 weight = -amp * 0.2 * clamp(sharpness, 0.0, 1.0);
+
+    vec3 color = (c + weight * (n + s + e + w)) / (1.0 + 4.0 * weight);
+    fragColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+}
@@ -0,0 +1,11 @@
+#version 430
+
+out vec2 uv;
+
+void main(){
+
+    // one triangle covering the window, uv runs from 0 to 1 across the visible part
+    vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    uv = p;
+    gl_Position = vec4(2.0 * p - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,19 @@
+/*
+    Cameras of all views of the frame, uploaded once by ViewSet, MAX_VIEWS is inserted on the CPU side
+    A draw covers views viewIndex to viewIndex + instances - 1 when the shader is compiled with VIEW_INSTANCING,
+    the GL_ARB_shader_viewport_layer_array directive then has to follow #version in the vertex shader
+*/
+
+struct View{
+    mat4 viewMx;
+    mat4 projMx;
+    mat4 invViewMx;
+    vec4 camPos; // w unused
+    vec4 viewport; // x, y, width, height in pixels
+};
+
+layout(std140, binding = 0) uniform Views{
+    View views[MAX_VIEWS];
+};
+
+uniform int viewIndex; // first view of the draw
@@ -0,0 +1,50 @@
+/*
+    Wake heightfields of WakeSolver, added on top of the FFT surface
+    Included with #include "Wake.glsl" after TextureTable.glsl; every active region is one layer of the wake array
+*/
+
+#ifdef BINDLESS
+uniform int wakeIndex;
+#define wake TABLE_SAMPLER2DARRAY(TEX_WAKE_0 + wakeIndex)
+#else
+uniform sampler2DArray wake; // height in .r
+#endif
+
+uniform vec4 wakeRegions[MAX_WAKE_REGIONS]; // corner x, corner z, world size, unused
+uniform int wakeRegionCount;
+
+// texture coordinate in region r and the fade towards its border, where the solver absorbs the waves
+float wakeWeight(vec2 xz, int r, out vec3 coord){
+
+    vec2 uv = (xz - wakeRegions[r].xy) / wakeRegions[r].z;
+    coord = vec3(uv, float(r));
+    vec2 edge = min(uv, 1.0 - uv);
+    return smoothstep(0.0, 0.1, min(edge.x, edge.y));
+}
+
+float wakeHeight(vec2 xz){
+
+    float height = 0.0;
+    for(int r = 0; r < wakeRegionCount; r++){
+        vec3 coord;
+        float weight = wakeWeight(xz, r, coord);
+        if(weight > 0.0) height += weight * texture(wake, coord).r;
+    }
+    return height;
+}
+
+// (dh/dx, dh/dz) by central differences over one texel of each region
+vec2 wakeGradient(vec2 xz){
+
+    vec2 gradient = vec2(0.0);
+    for(int r = 0; r < wakeRegionCount; r++){
+        vec3 coord;
+        float weight = wakeWeight(xz, r, coord);
+        if(weight <= 0.0) continue;
+        vec2 texel = 1.0 / vec2(textureSize(wake, 0).xy);
+        float hx = texture(wake, coord + vec3(texel.x, 0.0, 0.0)).r - texture(wake, coord - vec3(texel.x, 0.0, 0.0)).r;
+        float hz = texture(wake, coord + vec3(0.0, texel.y, 0.0)).r - texture(wake, coord - vec3(0.0, texel.y, 0.0)).r;
+        gradient += weight * vec2(hx, hz) / (2.0 * texel * wakeRegions[r].z);
+    }
+    return gradient;
+}